@@ -0,0 +1,960 @@
+#include <ritobin/bin_alloc_stats.hpp>
+#include <ritobin/bin_compact.hpp>
+#include <ritobin/bin_io.hpp>
+#include <ritobin/bin_mmap.hpp>
+#include <ritobin/bin_types_helper.hpp>
+#include <ritobin/bin_unhash.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+static size_t peak_rss() noexcept {
+    return 0;
+}
+#else
+#include <sys/resource.h>
+// Peak resident set of whole process in bytes
+static size_t peak_rss() noexcept {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+#endif
+
+using ritobin::ArenaBin;
+using ritobin::Bin;
+using ritobin::CompactBin;
+using ritobin::CompactNode;
+using ritobin::MappedFile;
+using ritobin::Value;
+namespace fs = std::filesystem;
+
+// Every heap allocation goes through here so benchmarks can report live bytes and allocation counts.
+namespace alloc_stats = ritobin::alloc_stats;
+
+struct Timer {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    double elapsed_ms() const noexcept {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+static uint64_t float_bits(float value) noexcept {
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Sums hashes and float bits, same checksum is produced by both representations
+struct TreeChecksum {
+    uint64_t sum = 0;
+
+    void value(Value const& value) noexcept {
+        std::visit([this](auto const& value) {
+            using value_t = std::remove_cvref_t<decltype(value)>;
+            if constexpr (std::is_same_v<value_t, ritobin::F32>) {
+                sum += float_bits(value.value);
+            } else if constexpr (std::is_same_v<value_t, ritobin::Vec2>
+                                 || std::is_same_v<value_t, ritobin::Vec3>
+                                 || std::is_same_v<value_t, ritobin::Vec4>
+                                 || std::is_same_v<value_t, ritobin::Mtx44>) {
+                for (auto item: value.value) {
+                    sum += float_bits(item);
+                }
+            } else if constexpr (value_t::category == ritobin::Category::HASH) {
+                sum += value.value.hash();
+            } else if constexpr (value_t::category == ritobin::Category::CLASS) {
+                sum += value.name.hash();
+                for (auto const& field: value.items) {
+                    sum += field.key.hash();
+                    this->value(field.value);
+                }
+            } else if constexpr (value_t::category == ritobin::Category::MAP) {
+                for (auto const& pair: value.items) {
+                    this->value(pair.key);
+                    this->value(pair.value);
+                }
+            } else if constexpr (value_t::category == ritobin::Category::LIST
+                                 || value_t::category == ritobin::Category::OPTION) {
+                if (value.items.packed_type() != ritobin::Type::NONE) {
+                    std::visit([this, &value](auto&& prototype) {
+                        using item_t = std::remove_cvref_t<decltype(prototype)>;
+                        if constexpr (ritobin::is_packable<item_t>) {
+                            for (auto const& item: value.items.template packed<item_t>()) {
+                                this->value(item_t { item });
+                            }
+                        }
+                    }, ritobin::ValueHelper::type_to_value(value.items.packed_type()));
+                    return;
+                }
+                for (auto const& item: value.items) {
+                    this->value(item.value);
+                }
+            }
+        }, value);
+    }
+
+    void node(CompactBin const& bin, CompactNode const& node) noexcept {
+        if (node.flags & CompactNode::IS_FIELD) {
+            sum += node.key;
+        }
+        switch (node.type) {
+        case ritobin::Type::F32:
+            sum += static_cast<uint32_t>(node.data);
+            break;
+        case ritobin::Type::VEC2:
+            sum += static_cast<uint32_t>(node.data) + (node.data >> 32);
+            break;
+        case ritobin::Type::VEC3:
+        case ritobin::Type::VEC4:
+        case ritobin::Type::MTX44:
+            for (auto item: bin.vector(node)) {
+                sum += float_bits(item);
+            }
+            break;
+        case ritobin::Type::HASH:
+        case ritobin::Type::LINK:
+        case ritobin::Type::FILE:
+            sum += node.data;
+            break;
+        case ritobin::Type::POINTER:
+        case ritobin::Type::EMBED:
+            sum += static_cast<uint32_t>(node.data);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void tree(CompactBin const& bin, CompactNode const& node) noexcept {
+        this->node(bin, node);
+        for (auto const& child: bin.children(node)) {
+            tree(bin, child);
+        }
+    }
+};
+
+struct CompactResult {
+    size_t files = 0;
+    size_t bytes = 0;
+    size_t nodes = 0;
+    size_t tree_memory = 0;
+    size_t tree_allocations = 0;
+    size_t compact_memory = 0;
+    size_t compact_allocations = 0;
+    double tree_ms = 0;
+    double compact_tree_ms = 0;
+    double compact_linear_ms = 0;
+
+    void print(char const* name) const noexcept {
+        printf("%s: files=%zu input=%zuB nodes=%zu\n", name, files, bytes, nodes);
+        printf("  Bin:        %10zuB %8zu allocations %6.1fB/node, traverse %8.3fms\n",
+               tree_memory, tree_allocations, nodes ? (double)tree_memory / nodes : 0.0, tree_ms);
+        printf("  CompactBin: %10zuB %8zu allocations %6.1fB/node, traverse %8.3fms (linear %8.3fms)\n",
+               compact_memory, compact_allocations, nodes ? (double)compact_memory / nodes : 0.0,
+               compact_tree_ms, compact_linear_ms);
+    }
+
+    void add(CompactResult const& other) noexcept {
+        files += other.files;
+        bytes += other.bytes;
+        nodes += other.nodes;
+        tree_memory += other.tree_memory;
+        tree_allocations += other.tree_allocations;
+        compact_memory += other.compact_memory;
+        compact_allocations += other.compact_allocations;
+        tree_ms += other.tree_ms;
+        compact_tree_ms += other.compact_tree_ms;
+        compact_linear_ms += other.compact_linear_ms;
+    }
+};
+
+static std::vector<fs::path> collect_files(std::vector<std::string> const& inputs, std::string_view extension) {
+    std::vector<fs::path> files;
+    for (auto const& input: inputs) {
+        if (!fs::is_directory(input)) {
+            files.emplace_back(input);
+            continue;
+        }
+        for (auto const& entry: fs::recursive_directory_iterator(input)) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                files.push_back(entry.path());
+            }
+        }
+    }
+    return files;
+}
+
+static MappedFile map_file(fs::path const& path) {
+    auto file = fopen(path.generic_string().c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path.generic_string());
+    }
+    MappedFile data;
+    auto const ok = data.map(file);
+    fclose(file);
+    if (!ok) {
+        throw std::runtime_error("Failed to read file: " + path.generic_string());
+    }
+    return data;
+}
+
+// Compares memory and traversal cost of Bin against CompactBin
+static int bench_compact(std::vector<std::string> const& inputs, int iterations) {
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    CompactResult total = {};
+    for (auto const& path: collect_files(inputs, ".bin")) {
+        auto const data = map_file(path);
+        CompactResult result = { 1, data.size() };
+
+        auto const tree_live = alloc_stats::live.load();
+        auto const tree_count = alloc_stats::count.load();
+        Bin bin = {};
+        if (auto error = ritobin::io::read_binary(bin, data, compat); !error.empty()) {
+            fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+            continue;
+        }
+        result.tree_memory = alloc_stats::live - tree_live;
+        result.tree_allocations = alloc_stats::count - tree_count;
+
+        auto const compact_live = alloc_stats::live.load();
+        auto const compact_count = alloc_stats::count.load();
+        CompactBin compact = {};
+        if (auto error = ritobin::compact_bin(compact, bin); !error.empty()) {
+            fprintf(stderr, "Failed to compact %s: %s\n", path.generic_string().c_str(), error.c_str());
+            continue;
+        }
+        compact.nodes.shrink_to_fit();
+        compact.floats.shrink_to_fit();
+        compact.chars.shrink_to_fit();
+        result.compact_memory = alloc_stats::live - compact_live;
+        result.compact_allocations = alloc_stats::count - compact_count;
+        result.nodes = compact.nodes.size();
+
+        uint64_t tree_sum = 0;
+        uint64_t compact_sum = 0;
+        uint64_t linear_sum = 0;
+        Timer tree_timer = {};
+        for (int i = 0; i != iterations; i++) {
+            TreeChecksum checksum = {};
+            for (auto const& [name, value]: bin.sections) {
+                checksum.value(value);
+            }
+            tree_sum = checksum.sum;
+        }
+        result.tree_ms = tree_timer.elapsed_ms() / iterations;
+
+        Timer compact_timer = {};
+        for (int i = 0; i != iterations; i++) {
+            TreeChecksum checksum = {};
+            for (size_t section = 0; section != compact.sections.size(); section++) {
+                checksum.tree(compact, compact.root(section));
+            }
+            compact_sum = checksum.sum;
+        }
+        result.compact_tree_ms = compact_timer.elapsed_ms() / iterations;
+
+        Timer linear_timer = {};
+        for (int i = 0; i != iterations; i++) {
+            TreeChecksum checksum = {};
+            for (auto const& node: compact.nodes) {
+                checksum.node(compact, node);
+            }
+            linear_sum = checksum.sum;
+        }
+        result.compact_linear_ms = linear_timer.elapsed_ms() / iterations;
+
+        if (tree_sum != compact_sum || tree_sum != linear_sum) {
+            fprintf(stderr, "Checksum mismatch in %s\n", path.generic_string().c_str());
+            return EXIT_FAILURE;
+        }
+        result.print(path.generic_string().c_str());
+        total.add(result);
+    }
+    if (total.files > 1) {
+        total.print("total");
+    }
+    return EXIT_SUCCESS;
+}
+
+// Parses text dumps of given bins, memchr over same text is reported as memory bandwidth reference
+static int bench_text(std::vector<std::string> const& inputs, int iterations) {
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    size_t total_bytes = 0;
+    double total_read_ms = 0;
+    double total_scan_ms = 0;
+    for (auto const& path: collect_files(inputs, ".bin")) {
+        auto const data = map_file(path);
+        Bin bin = {};
+        if (auto error = ritobin::io::read_binary(bin, data, compat); !error.empty()) {
+            fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+            continue;
+        }
+        std::vector<char> text;
+        if (auto error = ritobin::io::write_text(bin, text); !error.empty()) {
+            fprintf(stderr, "Failed to write %s:\n%s", path.generic_string().c_str(), error.c_str());
+            continue;
+        }
+
+        // Fastest iteration is reported, it is the least disturbed by other processes
+        double read_ms = 0;
+        for (int i = 0; i != iterations; i++) {
+            Bin result = {};
+            Timer timer = {};
+            if (auto error = ritobin::io::read_text(result, text); !error.empty()) {
+                fprintf(stderr, "Failed to read text of %s:\n%s", path.generic_string().c_str(), error.c_str());
+                return EXIT_FAILURE;
+            }
+            auto const elapsed = timer.elapsed_ms();
+            read_ms = i == 0 ? elapsed : std::min(read_ms, elapsed);
+        }
+
+        size_t lines = 0;
+        double scan_ms = 0;
+        for (int i = 0; i != iterations; i++) {
+            Timer timer = {};
+            lines = 0;
+            for (char const* cur = text.data(), * end = cur + text.size(); cur != end; lines++) {
+                auto const next = static_cast<char const*>(memchr(cur, '\n', static_cast<size_t>(end - cur)));
+                cur = next ? next + 1 : end;
+            }
+            auto const elapsed = timer.elapsed_ms();
+            scan_ms = i == 0 ? elapsed : std::min(scan_ms, elapsed);
+        }
+
+        printf("%s: text=%zuB lines=%zu read_text %8.3fms %8.1fMB/s, memchr %8.3fms %8.1fMB/s\n",
+               path.generic_string().c_str(), text.size(), lines,
+               read_ms, text.size() / read_ms / 1000.0, scan_ms, text.size() / scan_ms / 1000.0);
+        total_bytes += text.size();
+        total_read_ms += read_ms;
+        total_scan_ms += scan_ms;
+    }
+    if (total_read_ms > 0 && total_scan_ms > 0) {
+        printf("total: text=%zuB read_text %8.1fMB/s, memchr %8.1fMB/s\n",
+               total_bytes, total_bytes / total_read_ms / 1000.0, total_bytes / total_scan_ms / 1000.0);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Reads and frees bins in a loop, once with values on global heap and once in ArenaBin
+static int bench_arena(std::vector<std::string> const& inputs, int iterations) {
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    double total_heap_ms = 0;
+    double total_arena_ms = 0;
+    for (auto const& path: collect_files(inputs, ".bin")) {
+        auto const data = map_file(path);
+
+        // Fastest iteration is reported, it is the least disturbed by other processes
+        double heap_ms = 0;
+        size_t heap_allocations = 0;
+        for (int i = 0; i != iterations; i++) {
+            auto const count = alloc_stats::count.load();
+            Timer timer = {};
+            {
+                Bin bin = {};
+                if (auto error = ritobin::io::read_binary(bin, data, compat); !error.empty()) {
+                    fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+                    return EXIT_FAILURE;
+                }
+            }
+            auto const elapsed = timer.elapsed_ms();
+            heap_ms = i == 0 ? elapsed : std::min(heap_ms, elapsed);
+            heap_allocations = alloc_stats::count - count;
+        }
+
+        double arena_ms = 0;
+        size_t arena_allocations = 0;
+        for (int i = 0; i != iterations; i++) {
+            auto const count = alloc_stats::count.load();
+            Timer timer = {};
+            {
+                ArenaBin bin {};
+                auto const scope = bin.scope();
+                if (auto error = ritobin::io::read_binary(bin.bin(), data, compat); !error.empty()) {
+                    fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+                    return EXIT_FAILURE;
+                }
+            }
+            auto const elapsed = timer.elapsed_ms();
+            arena_ms = i == 0 ? elapsed : std::min(arena_ms, elapsed);
+            arena_allocations = alloc_stats::count - count;
+        }
+
+        printf("%s: heap %8.3fms %8zu allocations, arena %8.3fms %8zu allocations\n",
+               path.generic_string().c_str(), heap_ms, heap_allocations, arena_ms, arena_allocations);
+        total_heap_ms += heap_ms;
+        total_arena_ms += arena_ms;
+    }
+    if (total_heap_ms > 0 && total_arena_ms > 0) {
+        printf("total: heap %8.3fms, arena %8.3fms\n", total_heap_ms, total_arena_ms);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Classes reachable from value, only Pointer and Embed have fields
+static void collect_classes(Value& value, std::vector<ritobin::FieldList*>& out) {
+    std::visit([&out](auto& value) {
+        using value_t = std::remove_cvref_t<decltype(value)>;
+        if constexpr (value_t::category == ritobin::Category::CLASS) {
+            out.push_back(&value.items);
+            for (auto& field: value.items) {
+                collect_classes(field.value, out);
+            }
+        } else if constexpr (value_t::category == ritobin::Category::MAP) {
+            for (auto& pair: value.items) {
+                collect_classes(pair.value, out);
+            }
+        } else if constexpr (value_t::category == ritobin::Category::LIST
+                             || value_t::category == ritobin::Category::OPTION) {
+            if (value.items.packed_type() == ritobin::Type::NONE) {
+                for (auto& item: value.items) {
+                    collect_classes(item.value, out);
+                }
+            }
+        }
+    }, value);
+}
+
+// Looks up every field of every class by key, with FieldList::find against plain linear scan
+static int bench_fields(std::vector<std::string> const& inputs, int iterations) {
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    for (auto const& path: collect_files(inputs, ".bin")) {
+        auto const data = map_file(path);
+        Bin bin = {};
+        if (auto error = ritobin::io::read_binary(bin, data, compat); !error.empty()) {
+            fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+            return EXIT_FAILURE;
+        }
+        std::vector<ritobin::FieldList*> classes = {};
+        for (auto& [name, section]: bin.sections) {
+            collect_classes(section, classes);
+        }
+        size_t lookups = 0;
+        size_t widest = 0;
+        for (auto const fields: classes) {
+            fields->build_index();
+            lookups += fields->size();
+            widest = std::max(widest, fields->size());
+        }
+
+        double linear_ms = 0;
+        double indexed_ms = 0;
+        uint64_t linear_sum = 0;
+        uint64_t indexed_sum = 0;
+        for (int i = 0; i != iterations; i++) {
+            Timer timer = {};
+            for (auto const fields: classes) {
+                auto const& scanned = *fields;
+                for (auto const& field: scanned) {
+                    for (auto const& other: scanned) {
+                        if (other.key.hash() == field.key.hash()) {
+                            linear_sum += reinterpret_cast<uintptr_t>(&other);
+                            break;
+                        }
+                    }
+                }
+            }
+            auto const elapsed = timer.elapsed_ms();
+            linear_ms = i == 0 ? elapsed : std::min(linear_ms, elapsed);
+        }
+        for (int i = 0; i != iterations; i++) {
+            Timer timer = {};
+            for (auto const fields: classes) {
+                auto const& indexed = *fields;
+                for (auto const& field: indexed) {
+                    indexed_sum += reinterpret_cast<uintptr_t>(indexed.find(field.key));
+                }
+            }
+            auto const elapsed = timer.elapsed_ms();
+            indexed_ms = i == 0 ? elapsed : std::min(indexed_ms, elapsed);
+        }
+        if (linear_sum != indexed_sum) {
+            fprintf(stderr, "Lookup mismatch in %s\n", path.generic_string().c_str());
+            return EXIT_FAILURE;
+        }
+        printf("%s: classes=%zu lookups=%zu widest=%zu, linear %8.3fms, find %8.3fms\n",
+               path.generic_string().c_str(), classes.size(), lookups, widest, linear_ms, indexed_ms);
+    }
+    return EXIT_SUCCESS;
+}
+
+// Hashes names one at a time and in batches, names are last word of every line in input files
+static int bench_hash(std::vector<std::string> const& inputs, int iterations) {
+    std::vector<MappedFile> datas = {};
+    std::vector<std::string_view> names = {};
+    size_t bytes = 0;
+    for (auto const& path: collect_files(inputs, ".txt")) {
+        auto const& data = datas.emplace_back(map_file(path));
+        auto text = std::string_view { data.data(), data.size() };
+        while (!text.empty()) {
+            auto line = text.substr(0, text.find('\n'));
+            text.remove_prefix(std::min(text.size(), line.size() + 1));
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (auto const space = line.rfind(' '); space != std::string_view::npos) {
+                line.remove_prefix(space + 1);
+            }
+            if (!line.empty()) {
+                names.push_back(line);
+                bytes += line.size();
+            }
+        }
+    }
+    if (names.empty()) {
+        fprintf(stderr, "No names found\n");
+        return EXIT_FAILURE;
+    }
+
+    auto const run = [&](char const* name, auto&& hash) {
+        double best_ms = 0;
+        for (int i = 0; i != iterations; i++) {
+            Timer timer = {};
+            hash();
+            auto const elapsed = timer.elapsed_ms();
+            best_ms = i == 0 ? elapsed : std::min(best_ms, elapsed);
+        }
+        printf("  %-12s %8.3fms %8.1fMB/s\n", name, best_ms, best_ms > 0 ? bytes / best_ms / 1000.0 : 0.0);
+    };
+    std::vector<uint32_t> fnv1a_single(names.size());
+    std::vector<uint32_t> fnv1a_batch(names.size());
+    std::vector<uint64_t> xxh64_single(names.size());
+    std::vector<uint64_t> xxh64_batch(names.size());
+    printf("names=%zu bytes=%zu\n", names.size(), bytes);
+    run("fnv1a", [&] {
+        for (size_t i = 0; i != names.size(); i++) {
+            fnv1a_single[i] = ritobin::FNV1a::fnv1a(names[i]);
+        }
+    });
+    run("fnv1a batch", [&] {
+        ritobin::fnv1a_batch(names, fnv1a_batch);
+    });
+    run("xxh64", [&] {
+        for (size_t i = 0; i != names.size(); i++) {
+            xxh64_single[i] = ritobin::XXH64::xxh64(names[i]);
+        }
+    });
+    run("xxh64 batch", [&] {
+        ritobin::xxh64_batch(names, xxh64_batch);
+    });
+    if (fnv1a_single != fnv1a_batch || xxh64_single != xxh64_batch) {
+        fprintf(stderr, "Batch hashes do not match\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Reproducible bins that stress one part of every format each, hashes are left without names
+// and every name used is kept so unhasher can be filled with them.
+struct Synthetic {
+    uint64_t state = 0x5EED;
+    std::vector<std::string> fnv1a_names = {};
+    std::vector<std::string> xxh64_names = {};
+
+    // splitmix64
+    uint64_t next() noexcept {
+        auto z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t below(uint32_t count) noexcept {
+        return static_cast<uint32_t>(next() % count);
+    }
+
+    float real() noexcept {
+        return static_cast<float>(static_cast<int32_t>(below(2000000)) - 1000000) / 1000.0f;
+    }
+
+    ritobin::FNV1a name(char const* prefix) {
+        auto& name = fnv1a_names.emplace_back(prefix + std::to_string(next() % 100000));
+        return ritobin::FNV1a::fnv1a(name);
+    }
+
+    ritobin::XXH64 path() {
+        auto& name = xxh64_names.emplace_back("assets/synthetic/" + std::to_string(next() % 100000) + ".dds");
+        return ritobin::XXH64::xxh64(name);
+    }
+
+    std::string text(size_t size) {
+        // Quotes, escapes and multi byte characters take slow paths of text and json writers
+        static constexpr std::string_view pieces[] = {
+            "Lorem ipsum ", "dolor sit amet, ", "\"quoted\" ", "back\\slash ", "new\nline ", "tab\t",
+            "\xC5\xBElu\xC5\xA5ou\xC4\x8Dk\xC3\xBD ",
+        };
+        auto result = std::string{};
+        while (result.size() < size) {
+            result += pieces[below(std::size(pieces))];
+        }
+        return result;
+    }
+
+    Value scalar() {
+        switch (below(6)) {
+        case 0: return ritobin::Bool { below(2) == 1 };
+        case 1: return ritobin::U32 { static_cast<uint32_t>(next()) };
+        case 2: return ritobin::F32 { real() };
+        case 3: return ritobin::Vec3 { { real(), real(), real() } };
+        case 4: return ritobin::String { ritobin::BinString(text(8 + below(24))) };
+        default: return ritobin::Hash { name("Value") };
+        }
+    }
+
+    ritobin::Embed embed(size_t depth) {
+        auto result = ritobin::Embed { name("Class") };
+        for (size_t i = 0, count = 2 + below(4); i != count; i++) {
+            result.items.emplace_back(name("m"), scalar());
+        }
+        if (depth != 0) {
+            auto child = embed(depth - 1);
+            if (below(2)) {
+                result.items.emplace_back(name("m"), ritobin::Pointer { child.name, std::move(child.items) });
+            } else {
+                result.items.emplace_back(name("m"), std::move(child));
+            }
+        }
+        return result;
+    }
+
+    template<typename T, typename F>
+    ritobin::List list(size_t count, F&& make) {
+        auto result = ritobin::List { T::type };
+        for (size_t i = 0; i != count; i++) {
+            result.items.emplace_back(make());
+        }
+        return result;
+    }
+
+    Bin bin(std::string_view kind, size_t entry_count, auto&& make_entry) {
+        auto result = Bin {};
+        result.sections.emplace("type", ritobin::String { kind == "patch" ? "PTCH" : "PROP" });
+        result.sections.emplace("version", ritobin::U32 { 3 });
+        auto linked = ritobin::List { ritobin::Type::STRING };
+        linked.items.emplace_back(ritobin::String { "data/synthetic/linked.bin" });
+        result.sections.emplace("linked", std::move(linked));
+        auto entries = ritobin::Map { ritobin::Type::HASH, ritobin::Type::EMBED };
+        for (size_t i = 0; i != entry_count; i++) {
+            auto entry = make_entry();
+            entries.items.emplace_back(ritobin::Hash { name("Entries/") }, std::move(entry));
+        }
+        result.sections.emplace("entries", std::move(entries));
+        return result;
+    }
+
+    // Name and bin of every kind of synthetic input
+    std::vector<std::pair<std::string, Bin>> corpus() {
+        auto result = std::vector<std::pair<std::string, Bin>> {};
+        result.emplace_back("deep_embeds", bin("deep_embeds", 4000, [&] {
+            return embed(12);
+        }));
+        result.emplace_back("float_lists", bin("float_lists", 40, [&] {
+            auto entry = ritobin::Embed { name("Class") };
+            entry.items.emplace_back(name("m"), list<ritobin::F32>(20000, [&] { return ritobin::F32 { real() }; }));
+            entry.items.emplace_back(name("m"), list<ritobin::Vec3>(4000, [&] {
+                return ritobin::Vec3 { { real(), real(), real() } };
+            }));
+            return entry;
+        }));
+        result.emplace_back("hash_maps", bin("hash_maps", 200, [&] {
+            auto entry = ritobin::Embed { name("Class") };
+            auto links = ritobin::Map { ritobin::Type::HASH, ritobin::Type::LINK };
+            auto files = ritobin::Map { ritobin::Type::HASH, ritobin::Type::FILE };
+            for (size_t i = 0; i != 200; i++) {
+                links.items.emplace_back(ritobin::Hash { name("Key") }, ritobin::Link { name("Entries/") });
+                files.items.emplace_back(ritobin::Hash { name("Key") }, ritobin::File { path() });
+            }
+            entry.items.emplace_back(name("m"), std::move(links));
+            entry.items.emplace_back(name("m"), std::move(files));
+            return entry;
+        }));
+        result.emplace_back("long_strings", bin("long_strings", 200, [&] {
+            auto entry = ritobin::Embed { name("Class") };
+            entry.items.emplace_back(name("m"), ritobin::String { ritobin::BinString(text(16 * 1024)) });
+            entry.items.emplace_back(name("m"), list<ritobin::String>(32, [&] {
+                return ritobin::String { ritobin::BinString(text(64 + below(512))) };
+            }));
+            return entry;
+        }));
+        auto patch = bin("patch", 500, [&] {
+            return embed(4);
+        });
+        auto patches = ritobin::Map { ritobin::Type::HASH, ritobin::Type::EMBED };
+        for (size_t i = 0; i != 5000; i++) {
+            auto item = ritobin::Embed { ritobin::FNV1a("patch") };
+            item.items.emplace_back(ritobin::FNV1a("path"), ritobin::String { "mSpellData.mEffectAmount" });
+            item.items.emplace_back(ritobin::FNV1a("value"), scalar());
+            patches.items.emplace_back(ritobin::Hash { name("Entries/") }, std::move(item));
+        }
+        patch.sections.emplace("patches", std::move(patches));
+        result.emplace_back("patch", std::move(patch));
+        return result;
+    }
+
+    void fill(ritobin::BinUnhasher& unhasher) const {
+        for (auto const& name: fnv1a_names) {
+            unhasher.fnv1a.emplace(ritobin::FNV1a::fnv1a(name), name);
+        }
+        for (auto const& name: xxh64_names) {
+            unhasher.xxh64.emplace(ritobin::XXH64::xxh64(name), name);
+        }
+    }
+};
+
+// Writes synthetic corpus as .bin files
+static int bench_generate(std::vector<std::string> const& inputs) {
+    if (inputs.size() != 1) {
+        fprintf(stderr, "generate needs output directory\n");
+        return EXIT_FAILURE;
+    }
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    auto synthetic = Synthetic {};
+    fs::create_directories(inputs.front());
+    for (auto const& [name, bin]: synthetic.corpus()) {
+        auto data = std::vector<char> {};
+        if (auto error = ritobin::io::write_binary(bin, data, compat); !error.empty()) {
+            fprintf(stderr, "Failed to write %s:\n%s", name.c_str(), error.c_str());
+            return EXIT_FAILURE;
+        }
+        auto const path = (fs::path(inputs.front()) / (name + ".bin")).generic_string();
+        auto file = fopen(path.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "Failed to open %s\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+        printf("%s: %zuB\n", path.c_str(), data.size());
+    }
+    return EXIT_SUCCESS;
+}
+
+// Best time, allocations and peak heap growth of one operation over bytes of its input or output
+struct SuiteResult {
+    std::string_view format = {};
+    char const* operation = "";
+    std::string error = {};
+    size_t bytes = 0;
+    double ms = 0;
+    size_t allocations = 0;
+    size_t peak_heap = 0;
+
+    double mb_per_s() const noexcept {
+        return ms > 0 ? bytes / ms / 1000.0 : 0.0;
+    }
+
+    double allocations_per_mb() const noexcept {
+        return bytes ? allocations / (bytes / 1000000.0) : 0.0;
+    }
+
+    // Runs prepare outside of measurement before every iteration
+    template<typename P, typename F>
+    static SuiteResult measure(std::string_view format, char const* operation, int iterations, P&& prepare, F&& run) {
+        auto result = SuiteResult { format, operation };
+        for (int i = 0; i != iterations && result.error.empty(); i++) {
+            prepare();
+            auto const count = alloc_stats::count.load();
+            auto const live = alloc_stats::reset_peak();
+            Timer timer = {};
+            result.error = run(result.bytes);
+            auto const elapsed = timer.elapsed_ms();
+            result.ms = i == 0 ? elapsed : std::min(result.ms, elapsed);
+            result.allocations = alloc_stats::count - count;
+            result.peak_heap = alloc_stats::peak - live;
+        }
+        return result;
+    }
+};
+
+// Escapes only what synthetic names, formats and error messages can contain
+static std::string json_string(std::string_view str) {
+    auto result = std::string { '"' };
+    for (auto c: str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += ' ';
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+// Unhashes, writes and reads back given bins with every DynamicFormat
+static int bench_suite(std::vector<std::string> inputs, int iterations) {
+    auto json = false;
+    if (auto const flag = std::find(inputs.begin(), inputs.end(), "--json"); flag != inputs.end()) {
+        json = true;
+        inputs.erase(flag);
+    }
+    auto synthetic = Synthetic {};
+    auto corpus = std::vector<std::pair<std::string, Bin>> {};
+    if (inputs.empty()) {
+        corpus = synthetic.corpus();
+    } else {
+        for (auto const& path: collect_files(inputs, ".bin")) {
+            auto const data = map_file(path);
+            auto bin = Bin {};
+            auto const format = ritobin::io::DynamicFormat::guess(data, path.generic_string());
+            if (!format) {
+                fprintf(stderr, "Failed to guess format of %s\n", path.generic_string().c_str());
+                return EXIT_FAILURE;
+            }
+            if (auto error = format->read(bin, data); !error.empty()) {
+                fprintf(stderr, "Failed to read %s:\n%s", path.generic_string().c_str(), error.c_str());
+                return EXIT_FAILURE;
+            }
+            corpus.emplace_back(path.generic_string(), std::move(bin));
+        }
+    }
+    // Names of file inputs come from compiled tables in current directory, see ritobin_cli -c
+    auto unhasher = ritobin::BinUnhasher {};
+    synthetic.fill(unhasher);
+    unhasher.load_fnv1a_DB("hashes.fnv1a.db");
+    unhasher.load_xxh64_DB("hashes.xxh64.db");
+
+    auto const compat = ritobin::io::BinCompat::get("bin");
+    auto results = std::vector<std::pair<std::string, std::vector<SuiteResult>>> {};
+    for (auto& [name, bin]: corpus) {
+        auto& file_results = results.emplace_back(name, std::vector<SuiteResult> {}).second;
+        auto binary = std::vector<char> {};
+        if (auto error = ritobin::io::write_binary(bin, binary, compat); !error.empty()) {
+            fprintf(stderr, "Failed to write %s:\n%s", name.c_str(), error.c_str());
+            return EXIT_FAILURE;
+        }
+
+        // Unhashed tree is what text and json writers normally get
+        auto hashed = Bin {};
+        file_results.push_back(SuiteResult::measure("", "unhash", iterations, [&] {
+            hashed = {};
+            ritobin::io::read_binary(hashed, binary, compat);
+        }, [&](size_t& bytes) {
+            bytes = binary.size();
+            unhasher.unhash_bin(hashed);
+            return std::string {};
+        }));
+        bin = std::move(hashed);
+
+        for (auto format: ritobin::io::DynamicFormat::list()) {
+            auto data = std::vector<char> {};
+            file_results.push_back(SuiteResult::measure(format->name(), "write", iterations, [&] {
+                data = {};
+            }, [&](size_t& bytes) {
+                auto error = format->write(bin, data);
+                bytes = data.size();
+                return error;
+            }));
+
+            auto readback = Bin {};
+            file_results.push_back(SuiteResult::measure(format->name(), "read", iterations, [&] {
+                readback = {};
+            }, [&](size_t& bytes) {
+                bytes = data.size();
+                return format->read(readback, data);
+            }));
+        }
+    }
+
+    if (json) {
+        printf("{\n  \"iterations\": %d,\n  \"peak_rss\": %zu,\n  \"inputs\": [", iterations, peak_rss());
+        for (size_t f = 0; f != results.size(); f++) {
+            auto const& [name, file_results] = results[f];
+            printf("%s\n    {\n      \"name\": %s,\n      \"results\": [", f ? "," : "", json_string(name).c_str());
+            for (size_t r = 0; r != file_results.size(); r++) {
+                auto const& result = file_results[r];
+                printf("%s\n        { \"format\": %s, \"operation\": \"%s\", ", r ? "," : "",
+                       json_string(result.format).c_str(), result.operation);
+                if (!result.error.empty()) {
+                    printf("\"error\": %s }", json_string(result.error).c_str());
+                    continue;
+                }
+                printf("\"bytes\": %zu, \"ms\": %.3f, \"mb_per_s\": %.1f, \"allocations\": %zu, "
+                       "\"allocations_per_mb\": %.1f, \"peak_heap\": %zu }",
+                       result.bytes, result.ms, result.mb_per_s(), result.allocations,
+                       result.allocations_per_mb(), result.peak_heap);
+            }
+            printf("\n      ]\n    }");
+        }
+        printf("\n  ]\n}\n");
+        return EXIT_SUCCESS;
+    }
+    for (auto const& [name, file_results]: results) {
+        printf("%s:\n", name.c_str());
+        for (auto const& result: file_results) {
+            printf("  %-12.*s %-6s ", static_cast<int>(result.format.size()), result.format.data(), result.operation);
+            if (!result.error.empty()) {
+                // Last line of error trace is where it failed
+                auto error = std::string_view { result.error };
+                while (error.ends_with('\n')) {
+                    error.remove_suffix(1);
+                }
+                error.remove_prefix(error.rfind('\n') + 1);
+                printf("%.*s\n", static_cast<int>(error.size()), error.data());
+                continue;
+            }
+            printf("%10zuB %8.3fms %8.1fMB/s %10.1f allocations/MB %10zuB peak heap\n",
+                   result.bytes, result.ms, result.mb_per_s(), result.allocations_per_mb(), result.peak_heap);
+        }
+    }
+    printf("peak rss: %zuB\n", peak_rss());
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    alloc_stats::enabled = true;
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <benchmark> <files or directories...>\n", argv[0]);
+        fprintf(stderr, "Benchmarks:\n");
+        fprintf(stderr, "\t- compact: memory and traversal of Bin vs CompactBin\n");
+        fprintf(stderr, "\t- text: read_text throughput on text dumps of bins\n");
+        fprintf(stderr, "\t- arena: read_binary and free on global heap vs ArenaBin\n");
+        fprintf(stderr, "\t- fields: find_field by key on every class vs linear scan\n");
+        fprintf(stderr, "\t- hash: fnv1a and xxh64 one name at a time vs batched, on last word of text lines\n");
+        fprintf(stderr, "\t- suite [--json]: unhash and every format's write and read, synthetic corpus when no files given\n");
+        fprintf(stderr, "\t- generate <directory>: write synthetic corpus used by suite as .bin files\n");
+        return EXIT_FAILURE;
+    }
+    try {
+        auto const name = std::string_view{ argv[1] };
+        auto const inputs = std::vector<std::string>(argv + 2, argv + argc);
+        if (name == "compact") {
+            return bench_compact(inputs, 10);
+        }
+        if (name == "text") {
+            return bench_text(inputs, 10);
+        }
+        if (name == "arena") {
+            return bench_arena(inputs, 10);
+        }
+        if (name == "fields") {
+            return bench_fields(inputs, 10);
+        }
+        if (name == "hash") {
+            return bench_hash(inputs, 10);
+        }
+        if (name == "suite") {
+            return bench_suite(inputs, 3);
+        }
+        if (name == "generate") {
+            return bench_generate(inputs);
+        }
+        fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+        return EXIT_FAILURE;
+    } catch (std::exception const& err) {
+        fprintf(stderr, "%s\n", err.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -1,9 +1,26 @@
 #include <cstdlib>
 #include <argparse.hpp>
+#include <ritobin/bin_alloc_stats.hpp>
+#include <ritobin/bin_crack.hpp>
 #include <ritobin/bin_io.hpp>
+#include <ritobin/bin_mmap.hpp>
+#include <ritobin/bin_numconv.hpp>
+#include <ritobin/bin_types_helper.hpp>
 #include <ritobin/bin_unhash.hpp>
+#include <ritobin/bin_view.hpp>
 #include <optional>
 #include <filesystem>
+#include <fstream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 #ifdef WIN32
 #include <fcntl.h>
@@ -14,14 +31,462 @@ static void set_binary_mode(FILE* file) {
     }
 }
 #else
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
 static void set_binary_mode(FILE*) {}
 #endif
 
+// Heap allocations, counted only while --stats is on.
+// Files converted on single thread use counters of that thread, others use process wide ones.
+namespace alloc_stats = ritobin::alloc_stats;
+
+using ritobin::ArenaBin;
 using ritobin::Bin;
 using ritobin::BinUnhasher;
+using ritobin::HashCracker;
+using ritobin::MappedFile;
 using ritobin::io::DynamicFormat;
 namespace fs = std::filesystem;
 
+static std::string to_hex(uint64_t value) {
+    char str[17] = {};
+    snprintf(str, sizeof(str), "%016llx", static_cast<unsigned long long>(value));
+    return str;
+}
+
+// Outputs stored under hash of input bytes and everything else that changes output.
+// Entries are written to temporary file and renamed, concurrent writers of same key are harmless.
+struct ConversionCache {
+    fs::path dir = {};
+
+    fs::path path(std::string const& key) const {
+        return dir / key.substr(0, 2) / key;
+    }
+
+    bool load(std::string const& key, std::vector<char>& out) const {
+        auto file = fopen(path(key).generic_string().c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        MappedFile data;
+        auto const ok = data.map(file);
+        fclose(file);
+        if (!ok) {
+            return false;
+        }
+        out.assign(data.data(), data.data() + data.size());
+        return true;
+    }
+
+    void store(std::string const& key, std::vector<char> const& data) const {
+        auto const target = path(key);
+        auto ec = std::error_code{};
+        fs::create_directories(target.parent_path(), ec);
+        auto const id = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        auto const temp = target.generic_string() + ".tmp" + std::to_string(id);
+        auto file = fopen(temp.c_str(), "wb");
+        if (!file) {
+            return;
+        }
+        auto const ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+        if (fclose(file) == 0 && ok) {
+            fs::rename(temp, target, ec);
+        }
+        if (!ok || ec) {
+            fs::remove(temp, ec);
+        }
+    }
+};
+
+// Size and modification time of every input converted by previous recursive run, kept in output directory.
+// Inputs whose size, time and settings still match are skipped as long as their output exists.
+struct Manifest {
+    struct Entry {
+        uintmax_t size = {};
+        int64_t mtime = {};
+        std::string settings = {};
+    };
+
+    static inline constexpr char file_name[] = ".ritobin_manifest";
+
+    fs::path file = {};
+    std::mutex lock = {};
+    std::map<std::string, Entry> entries = {};
+
+    // Lines are: size mtime settings path
+    void load(fs::path const& dir) {
+        file = dir / file_name;
+        auto input = std::ifstream(file);
+        auto line = std::string{};
+        while (std::getline(input, line)) {
+            auto stream = std::istringstream(line);
+            auto entry = Entry{};
+            if (stream >> entry.size >> entry.mtime >> entry.settings && stream.get() == ' ') {
+                auto path = std::string{};
+                std::getline(stream, path);
+                entries[path] = std::move(entry);
+            }
+        }
+    }
+
+    void save() {
+        auto const temp = file.generic_string() + ".tmp";
+        fs::create_directories(file.parent_path());
+        {
+            auto output = std::ofstream(temp, std::ios::binary);
+            for (auto const& [path, entry]: entries) {
+                output << entry.size << ' ' << entry.mtime << ' ' << entry.settings << ' ' << path << '\n';
+            }
+            if (!output) {
+                throw std::runtime_error("Failed to write manifest: " + temp);
+            }
+        }
+        fs::rename(temp, file);
+    }
+
+    static Entry stat(fs::path const& path, std::string const& settings) {
+        return Entry {
+            fs::file_size(path),
+            static_cast<int64_t>(fs::last_write_time(path).time_since_epoch().count()),
+            settings,
+        };
+    }
+
+    bool unchanged(std::string const& path, Entry const& entry) {
+        auto guard = std::lock_guard { lock };
+        auto const i = entries.find(path);
+        return i != entries.end()
+                && i->second.size == entry.size
+                && i->second.mtime == entry.mtime
+                && i->second.settings == entry.settings;
+    }
+
+    void update(std::string const& path, Entry entry) {
+        auto guard = std::lock_guard { lock };
+        entries[path] = std::move(entry);
+    }
+};
+
+static std::string json_string(std::string_view str) {
+    auto result = std::string { '"' };
+    for (auto c: str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[7] = {};
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            result += escaped;
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+// Where time and allocations of converting one file went, see --stats
+struct FileStats {
+    enum Phase {
+        READ,
+        PARSE,
+        LOAD_HASHES,
+        UNHASH,
+        SERIALIZE,
+        WRITE,
+        PHASE_COUNT,
+    };
+
+    static inline constexpr char const* phase_names[PHASE_COUNT] = {
+        "read", "parse", "load_hashes", "unhash", "serialize", "write",
+    };
+
+    struct PhaseStats {
+        double ms = {};
+        size_t bytes = {};
+        size_t allocations = {};
+        size_t allocated_bytes = {};
+    };
+
+    // Measures from construction to stop(), allocations of this thread only when local is set
+    struct Timer {
+        bool local = {};
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t count = local ? alloc_stats::thread_count : alloc_stats::count.load();
+        size_t bytes = local ? alloc_stats::thread_bytes : alloc_stats::bytes.load();
+
+        void stop(FileStats* stats, Phase phase, size_t data_size) const noexcept {
+            if (!stats) {
+                return;
+            }
+            auto& result = stats->phases[phase];
+            result.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            result.bytes += data_size;
+            result.allocations += (local ? alloc_stats::thread_count : alloc_stats::count.load()) - count;
+            result.allocated_bytes += (local ? alloc_stats::thread_bytes : alloc_stats::bytes.load()) - bytes;
+        }
+    };
+
+    std::string file = {};
+    size_t files = {};
+    size_t cached = {};
+    std::array<PhaseStats, PHASE_COUNT> phases = {};
+    std::array<size_t, 256> nodes = {};
+    ritobin::UnhashStats unhash = {};
+
+    void count_nodes(ritobin::Value const& value) noexcept {
+        nodes[static_cast<uint8_t>(ritobin::ValueHelper::value_to_type(value))]++;
+        std::visit([this](auto const& value) noexcept {
+            using value_t = std::remove_cvref_t<decltype(value)>;
+            if constexpr (value_t::category == ritobin::Category::LIST || value_t::category == ritobin::Category::OPTION) {
+                if (auto const type = value.items.packed_type(); type != ritobin::Type::NONE) {
+                    nodes[static_cast<uint8_t>(type)] += value.items.size();
+                    return;
+                }
+                for (auto const& item: value.items) {
+                    count_nodes(item.value);
+                }
+            } else if constexpr (value_t::category == ritobin::Category::MAP) {
+                for (auto const& item: value.items) {
+                    count_nodes(item.key);
+                    count_nodes(item.value);
+                }
+            } else if constexpr (value_t::category == ritobin::Category::CLASS) {
+                for (auto const& item: value.items) {
+                    count_nodes(item.value);
+                }
+            }
+        }, value);
+    }
+
+    void add(FileStats const& other) noexcept {
+        files += other.files;
+        cached += other.cached;
+        for (size_t i = 0; i != PHASE_COUNT; i++) {
+            phases[i].ms += other.phases[i].ms;
+            phases[i].bytes += other.phases[i].bytes;
+            phases[i].allocations += other.phases[i].allocations;
+            phases[i].allocated_bytes += other.phases[i].allocated_bytes;
+        }
+        for (size_t i = 0; i != nodes.size(); i++) {
+            nodes[i] += other.nodes[i];
+        }
+        unhash.add(other.unhash);
+    }
+
+    static double percent(size_t part, size_t total) noexcept {
+        return total ? part * 100.0 / total : 0.0;
+    }
+
+    void print_text(std::ostream& out) const {
+        char line[256] = {};
+        out << file << ": " << files << " files, " << cached << " from cache" << std::endl;
+        for (size_t i = 0; i != PHASE_COUNT; i++) {
+            auto const& phase = phases[i];
+            snprintf(line, sizeof(line), "  %-12s %10.3fms %12zuB %10zu allocations %12zuB allocated",
+                     phase_names[i], phase.ms, phase.bytes, phase.allocations, phase.allocated_bytes);
+            out << line << std::endl;
+        }
+        out << "  nodes:";
+        for (size_t i = 0; i != nodes.size(); i++) {
+            if (nodes[i]) {
+                out << ' ' << ritobin::ValueHelper::type_to_type_name(static_cast<ritobin::Type>(i)) << '=' << nodes[i];
+            }
+        }
+        out << std::endl;
+        snprintf(line, sizeof(line), "  unhash: fnv1a %zu lookups %.1f%% map %.1f%% db, xxh64 %zu lookups %.1f%% map %.1f%% db",
+                 unhash.fnv1a_lookups,
+                 percent(unhash.fnv1a_map_hits, unhash.fnv1a_lookups),
+                 percent(unhash.fnv1a_db_hits, unhash.fnv1a_lookups),
+                 unhash.xxh64_lookups,
+                 percent(unhash.xxh64_map_hits, unhash.xxh64_lookups),
+                 percent(unhash.xxh64_db_hits, unhash.xxh64_lookups));
+        out << line << std::endl;
+    }
+
+    void print_json(std::ostream& out) const {
+        char number[32] = {};
+        out << "{ \"file\": " << json_string(file) << ", \"files\": " << files << ", \"cached\": " << cached;
+        out << ", \"phases\": {";
+        for (size_t i = 0; i != PHASE_COUNT; i++) {
+            auto const& phase = phases[i];
+            snprintf(number, sizeof(number), "%.3f", phase.ms);
+            out << (i ? ", " : " ") << '"' << phase_names[i] << "\": { \"ms\": " << number
+                << ", \"bytes\": " << phase.bytes
+                << ", \"allocations\": " << phase.allocations
+                << ", \"allocated_bytes\": " << phase.allocated_bytes << " }";
+        }
+        out << " }, \"nodes\": {";
+        auto first = true;
+        for (size_t i = 0; i != nodes.size(); i++) {
+            if (nodes[i]) {
+                out << (first ? " " : ", ") << '"'
+                    << ritobin::ValueHelper::type_to_type_name(static_cast<ritobin::Type>(i)) << "\": " << nodes[i];
+                first = false;
+            }
+        }
+        out << " }, \"unhash\": { \"fnv1a_lookups\": " << unhash.fnv1a_lookups
+            << ", \"fnv1a_map_hits\": " << unhash.fnv1a_map_hits
+            << ", \"fnv1a_db_hits\": " << unhash.fnv1a_db_hits
+            << ", \"xxh64_lookups\": " << unhash.xxh64_lookups
+            << ", \"xxh64_map_hits\": " << unhash.xxh64_map_hits
+            << ", \"xxh64_db_hits\": " << unhash.xxh64_db_hits << " } }";
+    }
+};
+
+// Stats of every converted file, printed to stderr at end of run
+struct StatsReport {
+    bool json = {};
+    std::mutex lock = {};
+    std::vector<FileStats> files = {};
+
+    void add(FileStats stats) {
+        auto guard = std::lock_guard { lock };
+        files.push_back(std::move(stats));
+    }
+
+    void print() {
+        std::sort(files.begin(), files.end(), [](FileStats const& lhs, FileStats const& rhs) {
+            return lhs.file < rhs.file;
+        });
+        auto total = FileStats { "total" };
+        for (auto const& file: files) {
+            total.add(file);
+        }
+        if (json) {
+            std::cerr << "{\n  \"files\": [";
+            for (size_t i = 0; i != files.size(); i++) {
+                std::cerr << (i ? ",\n    " : "\n    ");
+                files[i].print_json(std::cerr);
+            }
+            std::cerr << "\n  ],\n  \"total\": ";
+            total.print_json(std::cerr);
+            std::cerr << "\n}" << std::endl;
+            return;
+        }
+        for (auto const& file: files) {
+            file.print_text(std::cerr);
+        }
+        if (files.size() > 1) {
+            total.print_text(std::cerr);
+        }
+    }
+};
+
+// Pool of threads running queued tasks, finish() runs everything still queued before joining
+struct WorkQueue {
+    std::mutex lock = {};
+    std::condition_variable ready = {};
+    std::deque<std::function<void()>> queue = {};
+    std::vector<std::thread> threads = {};
+    bool done = {};
+
+    explicit WorkQueue(size_t jobs) {
+        for (size_t i = 0; i != std::max(jobs, size_t{1}); i++) {
+            threads.emplace_back([this] { work(); });
+        }
+    }
+
+    WorkQueue(WorkQueue const&) = delete;
+    WorkQueue& operator=(WorkQueue const&) = delete;
+
+    ~WorkQueue() {
+        finish();
+    }
+
+    void push(std::function<void()> task) {
+        {
+            auto guard = std::lock_guard { lock };
+            queue.push_back(std::move(task));
+        }
+        ready.notify_one();
+    }
+
+    void finish() {
+        {
+            auto guard = std::lock_guard { lock };
+            done = true;
+        }
+        ready.notify_all();
+        for (auto& thread: threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+private:
+    void work() {
+        for (;;) {
+            auto guard = std::unique_lock { lock };
+            ready.wait(guard, [&] { return done || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            auto task = std::move(queue.front());
+            queue.pop_front();
+            guard.unlock();
+            task();
+        }
+    }
+};
+
+// One client of --serve, responses of requests still running hold it open
+struct Connection {
+    FILE* input = {};
+    FILE* output = {};
+    std::mutex write_lock = {};
+
+    Connection(FILE* input, FILE* output) noexcept : input(input), output(output) {}
+
+    Connection(Connection const&) = delete;
+    Connection& operator=(Connection const&) = delete;
+
+    ~Connection() {
+        if (input != stdin) {
+            fclose(input);
+        }
+        if (output != stdout) {
+            fclose(output);
+        }
+    }
+
+    // Longest header line accepted, file paths included
+    static inline constexpr size_t max_line_size = 8 * 1024;
+
+    // Header line without new line, false at end of stream or once line reaches max_line_size
+    bool read_line(std::string& line) {
+        line.clear();
+        for (int c; (c = getc(input)) != EOF;) {
+            if (c == '\n') {
+                return true;
+            }
+            if (line.size() == max_line_size) {
+                return false;
+            }
+            line.push_back(static_cast<char>(c));
+        }
+        return !line.empty() && line.size() != max_line_size;
+    }
+
+    // Largest input accepted in data request, bigger ones are refused before anything is allocated
+    static inline constexpr size_t max_data_size = size_t{ 256 } * 1024 * 1024;
+
+    bool read_data(std::vector<char>& data, size_t size) {
+        data.resize(size);
+        return fread(data.data(), 1, size, input) == size;
+    }
+
+    void respond(std::string const& id, bool ok, std::span<char const> data) {
+        auto guard = std::lock_guard { write_lock };
+        fprintf(output, "%s %s %zu\n", id.c_str(), ok ? "ok" : "error", data.size());
+        fwrite(data.data(), 1, data.size(), output);
+        fflush(output);
+    }
+};
+
 static DynamicFormat const* get_format(std::string const& name, std::string_view data, std::string const& file_name) {
     if (!name.empty()) {
         auto format = DynamicFormat::get(name);
@@ -42,6 +507,16 @@ struct Args {
     bool keep_hashed = {};
     bool recursive = {};
     bool log = {};
+    bool compile_hashes = {};
+    bool crack_hashes = {};
+    bool skip_unchanged = {};
+    bool stream = {};
+    size_t jobs = 1;
+    std::string serve = {};
+    size_t crack_depth = 2;
+    std::string crack_words = {};
+    std::string crack_prefixes = {};
+    std::string crack_suffixes = {};
 
     std::string dir = {};
     std::string input_file = {};
@@ -51,6 +526,13 @@ struct Args {
     std::string input_format = {};
     std::string output_format = {};
     std::shared_ptr<std::optional<BinUnhasher>> unhasher = {};
+    std::shared_ptr<std::once_flag> unhasher_once = {};
+    std::shared_ptr<ConversionCache> cache = {};
+    std::shared_ptr<std::string> hashes_version = {};
+    std::shared_ptr<std::once_flag> hashes_version_once = {};
+    std::shared_ptr<Manifest> manifest = {};
+    std::shared_ptr<StatsReport> stats = {};
+    std::optional<FileStats> file_stats = {};
 
     Args(int argc, char** argv) {
         argparse::ArgumentParser program("ritobin");
@@ -66,9 +548,63 @@ struct Args {
                 .help("log more")
                 .default_value(false)
                 .implicit_value(true);
+        program.add_argument("-j", "--jobs")
+                .help("number of threads to use, 0 for all cores")
+                .default_value(size_t{ 1 })
+                .action([](std::string const& value) -> size_t {
+                    size_t result = 0;
+                    if (!ritobin::to_num(value, result)) {
+                        throw std::runtime_error("Invalid number of jobs: " + value);
+                    }
+                    return result;
+                });
+        program.add_argument("-c", "--compile-hashes")
+                .help("compile hashes in hash directory into .db tables that load faster")
+                .default_value(false)
+                .implicit_value(true);
+        program.add_argument("--cache")
+                .default_value(std::string(""))
+                .help("directory to keep converted outputs in, inputs with same content are not converted again");
+        program.add_argument("--skip-unchanged")
+                .help("with -r skip inputs whose size and modification time did not change since last run")
+                .default_value(false)
+                .implicit_value(true);
+        program.add_argument("--stream")
+                .help("convert bin to text in single pass while reading, without --cache, uses less memory on big files")
+                .default_value(false)
+                .implicit_value(true);
+        program.add_argument("--stats")
+                .default_value(std::string(""))
+                .help("print time, bytes and allocations of every phase, node counts and unhash hits to stderr, as text or json");
+        program.add_argument("--serve")
+                .default_value(std::string(""))
+                .help("keep hashes loaded and convert requests read from unix socket at given path, - for stdin and stdout");
+        program.add_argument("--crack")
+                .help("guess names of hashes left unknown in input, found names are written to output in CDTB format")
+                .default_value(false)
+                .implicit_value(true);
+        program.add_argument("--crack-words")
+                .default_value(std::string(""))
+                .help("wordlist or CDTB file to take words for --crack from, names known in input are always used");
+        program.add_argument("--crack-depth")
+                .help("max number of words joined in one --crack candidate")
+                .default_value(size_t{ 2 })
+                .action([](std::string const& value) -> size_t {
+                    size_t result = 0;
+                    if (!ritobin::to_num(value, result)) {
+                        throw std::runtime_error("Invalid crack depth: " + value);
+                    }
+                    return result;
+                });
+        program.add_argument("--crack-prefixes")
+                .default_value(std::string(",m"))
+                .help("comma separated prefixes of --crack candidates, empty entry means no prefix");
+        program.add_argument("--crack-suffixes")
+                .default_value(std::string(""))
+                .help("comma separated suffixes of --crack candidates, empty entry means no suffix");
         program.add_argument("input")
                 .help("input file or directory")
-                .required();
+                .default_value(std::string(""));
         program.add_argument("output")
                 .help("output file or directory")
                 .default_value(std::string(""));
@@ -87,8 +623,35 @@ struct Args {
             keep_hashed = program.get<bool>("--keep-hashed");
             recursive = program.get<bool>("--recursive");
             log = program.get<bool>("--verbose");
+            compile_hashes = program.get<bool>("--compile-hashes");
+            crack_hashes = program.get<bool>("--crack");
+            skip_unchanged = program.get<bool>("--skip-unchanged");
+            stream = program.get<bool>("--stream");
+            serve = program.get<std::string>("--serve");
+            if (auto const stats_format = program.get<std::string>("--stats"); !stats_format.empty()) {
+                if (stats_format != "text" && stats_format != "json") {
+                    throw std::runtime_error("Invalid stats format: " + stats_format);
+                }
+                stats = std::make_shared<StatsReport>();
+                stats->json = stats_format == "json";
+                alloc_stats::enabled = true;
+            }
+            if (auto const cache_dir = program.get<std::string>("--cache"); !cache_dir.empty()) {
+                cache = std::make_shared<ConversionCache>(ConversionCache { cache_dir });
+            }
+            crack_words = program.get<std::string>("--crack-words");
+            crack_depth = program.get<size_t>("--crack-depth");
+            crack_prefixes = program.get<std::string>("--crack-prefixes");
+            crack_suffixes = program.get<std::string>("--crack-suffixes");
+            jobs = program.get<size_t>("--jobs");
+            if (jobs == 0) {
+                jobs = std::max(std::thread::hardware_concurrency(), 1u);
+            }
             input_format = program.get<std::string>("--input-format");
             output_format = program.get<std::string>("--output-format");
+            if (!compile_hashes && serve.empty() && program.get<std::string>("input").empty()) {
+                throw std::runtime_error("input: required.");
+            }
             if (recursive) {
                 input_dir = program.get<std::string>("input");
                 output_dir = program.get<std::string>("output");
@@ -106,13 +669,26 @@ struct Args {
             exit(-1);
         }
         unhasher = std::make_shared<std::optional<BinUnhasher>>(std::nullopt);
+        unhasher_once = std::make_shared<std::once_flag>();
+        hashes_version = std::make_shared<std::string>();
+        hashes_version_once = std::make_shared<std::once_flag>();
+    }
+
+    // Writes one line of log or error, lines of different threads never mix
+    template<typename... T>
+    static void log_line(T const&... parts) {
+        static std::mutex lock;
+        auto line = std::ostringstream{};
+        (line << ... << parts) << '\n';
+        auto guard = std::lock_guard { lock };
+        std::cerr << line.str() << std::flush;
     }
 
     template<char M>
     FILE* open_file(std::string const& name) {
         char mode[] = { M, 'b', '\0'};
         if (log) {
-            std::cerr << "Open file for " << mode << ": " << name << std::endl;
+            log_line("Open file for ", mode, ": ", name);
         }
         auto file = M == 'r' ? stdin : stdout;
         if (name == "-") {
@@ -134,61 +710,206 @@ struct Args {
         return file;
     }
 
-    void read(Bin& bin) {
+    MappedFile read_data() {
         auto file = open_file<'r'>(input_file);
 
-        std::vector<char> data;
-        char buffer[4096];
+        MappedFile data;
         if (log) {
-            std::cerr << "Reading..." << std::endl;
-        }
-        while (auto read = fread(buffer, 1, sizeof(buffer), file)) {
-            data.insert(data.end(), buffer, buffer + read);
+            log_line("Reading...");
         }
+        auto const ok = input_file == "-" ? data.read(file) : data.map(file);
         fclose(file);
+        if (!ok) {
+            throw std::runtime_error("Failed to read file!");
+        }
+        return data;
+    }
+
+    DynamicFormat const* read_format(std::string_view data) {
+        auto format = get_format(input_format, data, input_file);
+        if (output_file.empty() && output_format.empty()) {
+            output_format = format->oposite_name();
+        }
+        return format;
+    }
 
+    void parse(Bin& bin, std::span<char const> data, DynamicFormat const* format) {
         if (log) {
-            std::cerr << "Parsing..." << std::endl;
+            log_line("Parsing...");
         }
-        auto format = get_format(input_format, std::string_view{data.data(), data.size()}, input_file);
-        auto error = format->read(bin, data);
+        auto error = format->read(bin, data, jobs);
         if (!error.empty()) {
             throw std::runtime_error(error);
         }
-        if (output_file.empty() && output_format.empty()) {
-            output_format = format->oposite_name();
+    }
+
+    void read(Bin& bin) {
+        auto const data = read_data();
+        parse(bin, data, read_format({data.data(), data.size()}));
+    }
+
+    void load_fnv1a_CDTB(BinUnhasher& uh) {
+        uh.load_fnv1a_CDTB(dir + "/hashes.binentries.txt");
+        uh.load_fnv1a_CDTB(dir + "/hashes.binhashes.txt");
+        uh.load_fnv1a_CDTB(dir + "/hashes.bintypes.txt");
+        uh.load_fnv1a_CDTB(dir + "/hashes.binfields.txt");
+    }
+
+    void load_xxh64_CDTB(BinUnhasher& uh) {
+        uh.load_xxh64_CDTB(dir + "/hashes.game.txt");
+        uh.load_xxh64_CDTB(dir + "/hashes.lcu.txt");
+    }
+
+    void compile() {
+        if (dir.empty()) {
+            dir = ".";
+        }
+        if (log) {
+            log_line("Compiling hashes...");
+        }
+        auto uh = BinUnhasher{};
+        load_fnv1a_CDTB(uh);
+        load_xxh64_CDTB(uh);
+        if (!uh.save_fnv1a_DB(dir + "/hashes.fnv1a.db")) {
+            throw std::runtime_error("Failed to write: " + dir + "/hashes.fnv1a.db");
+        }
+        if (!uh.save_xxh64_DB(dir + "/hashes.xxh64.db")) {
+            throw std::runtime_error("Failed to write: " + dir + "/hashes.xxh64.db");
         }
     }
 
-    void unhash(Bin& bin) {
-        if (!keep_hashed) {
-            if (!*unhasher) {
-                if (log) {
-                    std::cerr << "Loading hashes..." << std::endl;
+    static std::vector<std::string> split_list(std::string_view list) {
+        std::vector<std::string> result;
+        for (;;) {
+            auto const comma = list.find(',');
+            result.emplace_back(list.substr(0, comma));
+            if (comma == std::string_view::npos) {
+                return result;
+            }
+            list.remove_prefix(comma + 1);
+        }
+    }
+
+    void crack() {
+        auto uh = BinUnhasher{};
+        auto collect = [&] {
+            ArenaBin bin {};
+            auto const scope = bin.scope();
+            read(bin.bin());
+            uh.collect_bin(bin.bin());
+        };
+        if (!recursive) {
+            collect();
+        } else {
+            auto const format = get_format(input_format.empty() ? "bin" : input_format, "", "");
+            for (auto const& entry: fs::recursive_directory_iterator(input_dir)) {
+                if (!entry.is_regular_file() || entry.path().extension() != format->default_extension()) {
+                    continue;
                 }
-                auto& uh = unhasher->emplace();
-                if (dir.empty()) {
-                    dir = ".";
+                input_file = entry.path().generic_string();
+                try {
+                    collect();
+                } catch (const std::runtime_error& err) {
+                    log_line("In: ", input_file, "\nError: ", err.what());
                 }
-                uh.load_fnv1a_CDTB(dir + "/hashes.binentries.txt");
-                uh.load_fnv1a_CDTB(dir + "/hashes.binhashes.txt");
-                uh.load_fnv1a_CDTB(dir + "/hashes.bintypes.txt");
-                uh.load_fnv1a_CDTB(dir + "/hashes.binfields.txt");
-                uh.load_xxh64_CDTB(dir + "/hashes.game.txt");
-                uh.load_xxh64_CDTB(dir + "/hashes.lcu.txt");
             }
+        }
+
+        if (log) {
+            log_line("Loading hashes...");
+        }
+        if (dir.empty()) {
+            dir = ".";
+        }
+        if (!uh.load_fnv1a_DB(dir + "/hashes.fnv1a.db")) {
+            load_fnv1a_CDTB(uh);
+        }
+
+        // Names already known in same bins follow same conventions, their words go first
+        auto cracker = HashCracker {};
+        cracker.jobs = jobs;
+        cracker.max_words = crack_depth;
+        cracker.prefixes = split_list(crack_prefixes);
+        cracker.suffixes = split_list(crack_suffixes);
+        for (auto hash: uh.fnv1a_wanted) {
+            if (auto i = uh.fnv1a.find(hash); i != uh.fnv1a.end()) {
+                cracker.add_words(i->second);
+            } else if (auto str = uh.fnv1a_db.find(hash); !str.empty()) {
+                cracker.add_words(str);
+            } else {
+                cracker.wanted.insert(hash);
+            }
+        }
+        if (!crack_words.empty() && !cracker.load_words(crack_words)) {
+            throw std::runtime_error("Failed to read words: " + crack_words);
+        }
+
+        if (log) {
+            log_line("Cracking ", cracker.wanted.size(), " hashes with ", cracker.candidate_count(), " candidates...");
+        }
+        auto const found = cracker.crack();
+        if (log) {
+            log_line("Found ", found.size(), " names");
+        }
+        auto const out = output_file.empty() ? (recursive ? output_dir : std::string("-")) : output_file;
+        if (!HashCracker::save_CDTB(out.empty() ? "-" : out, found)) {
+            throw std::runtime_error("Failed to write: " + out);
+        }
+    }
+
+    // Loads hashes once for all copies of Args.
+    // Text tables only keep names of hashes collect adds as wanted, precompiled tables are always used whole.
+    void load_hashes(std::function<void(BinUnhasher&)> const& collect = {}) {
+        std::call_once(*unhasher_once, [&] {
+            if (log) {
+                log_line("Loading hashes...");
+            }
+            auto& uh = unhasher->emplace();
+            if (dir.empty()) {
+                dir = ".";
+            }
+            auto const fnv1a_db = uh.load_fnv1a_DB(dir + "/hashes.fnv1a.db");
+            auto const xxh64_db = uh.load_xxh64_DB(dir + "/hashes.xxh64.db");
+            if (collect && !(fnv1a_db && xxh64_db)) {
+                collect(uh);
+            }
+            if (!fnv1a_db) {
+                load_fnv1a_CDTB(uh);
+            }
+            if (!xxh64_db) {
+                load_xxh64_CDTB(uh);
+            }
+        });
+    }
+
+    void unhash(Bin& bin) {
+        if (!keep_hashed) {
+            // Single conversion only needs names of hashes in this bin
+            auto timer = FileStats::Timer { jobs == 1 };
+            if (recursive || !serve.empty()) {
+                load_hashes();
+            } else {
+                load_hashes([&](BinUnhasher& uh) { uh.collect_bin(bin); });
+            }
+            timer.stop(file_stats ? &*file_stats : nullptr, FileStats::LOAD_HASHES, 0);
             if (log) {
-                std::cerr << "Unashing..." << std::endl;
+                log_line("Unashing...");
+            }
+            timer = FileStats::Timer { jobs == 1 };
+            auto unhash_stats = ritobin::UnhashStats {};
+            {
+                auto const scope = unhash_stats.scope();
+                (*unhasher)->unhash_bin(bin);
+            }
+            timer.stop(file_stats ? &*file_stats : nullptr, FileStats::UNHASH, 0);
+            if (file_stats) {
+                file_stats->unhash.add(unhash_stats);
             }
-            (*unhasher)->unhash_bin(bin);
         }
     }
 
-    void write(Bin& bin) {
+    DynamicFormat const* write_format() {
         auto format = get_format(output_format, "", output_file);
-        if (!keep_hashed && !format->output_allways_hashed()) {
-            unhash(bin);
-        }
         if (output_file.empty()) {
             if (input_file == "-") {
                 output_file = "-";
@@ -199,40 +920,392 @@ struct Args {
                 }
             }
         }
+        return format;
+    }
 
+    void serialize(Bin& bin, DynamicFormat const* format, std::vector<char>& data) {
         if (log) {
-            std::cerr << "Serializing..." << std::endl;
+            log_line("Serializing...");
         }
-        std::vector<char> data;
-        auto error = format->write(bin, data);
+        auto error = format->write(bin, data, jobs);
         if (!error.empty()) {
             throw std::runtime_error(error);
         }
+    }
 
+    void write_data(std::vector<char> const& data) {
         auto file = open_file<'w'>(output_file);
         if (log) {
-            std::cerr << "Writing data..." << std::endl;
+            log_line("Writing data...");
         }
         fwrite(data.data(), 1, data.size(), file);
         fflush(file);
         fclose(file);
     }
 
-    void run_once() {
+    // Names, sizes and times of hash files, output of unhashed formats changes with them
+    std::string const& get_hashes_version() {
+        std::call_once(*hashes_version_once, [&] {
+            auto listing = std::string{};
+            auto ec = std::error_code{};
+            auto files = std::vector<fs::path>{};
+            for (auto const& entry: fs::directory_iterator(dir.empty() ? "." : dir, ec)) {
+                if (entry.is_regular_file() && entry.path().filename().generic_string().starts_with("hashes.")) {
+                    files.push_back(entry.path());
+                }
+            }
+            std::sort(files.begin(), files.end());
+            for (auto const& path: files) {
+                auto const entry = Manifest::stat(path, "");
+                listing += path.filename().generic_string() + ' ' + std::to_string(entry.size)
+                           + ' ' + std::to_string(entry.mtime) + '\n';
+            }
+            *hashes_version = to_hex(ritobin::xxh64_bytes(listing));
+        });
+        return *hashes_version;
+    }
+
+    // Everything besides input bytes that output depends on
+    std::string settings_key(DynamicFormat const* input, DynamicFormat const* output) {
+        auto key = "ritobin-cache-1 " + std::string(input->name()) + ' ' + std::string(output->name());
+        if (keep_hashed || output->output_allways_hashed()) {
+            key += " hashed";
+        } else {
+            key += ' ' + get_hashes_version();
+        }
+        return to_hex(ritobin::xxh64_bytes(key));
+    }
+
+    // Parses and serializes data, going through cache when there is one
+    void convert(std::span<char const> data, DynamicFormat const* input, DynamicFormat const* output,
+                 std::vector<char>& out) {
+        auto key = std::string{};
+        if (cache) {
+            key = to_hex(ritobin::xxh64_bytes(data)) + '-' + settings_key(input, output);
+            if (cache->load(key, out)) {
+                if (log) {
+                    log_line("Found in cache: ", key);
+                }
+                if (file_stats) {
+                    file_stats->cached++;
+                }
+                return;
+            }
+        }
+        {
+            auto const stats = file_stats ? &*file_stats : nullptr;
+            auto timer = FileStats::Timer { jobs == 1 };
+            ArenaBin bin {};
+            auto const scope = bin.scope();
+            parse(bin.bin(), data, input);
+            timer.stop(stats, FileStats::PARSE, data.size());
+            if (stats) {
+                for (auto const& [name, value]: bin.bin().sections) {
+                    stats->count_nodes(value);
+                }
+            }
+            if (!output->output_allways_hashed()) {
+                unhash(bin.bin());
+            }
+            timer = FileStats::Timer { jobs == 1 };
+            serialize(bin.bin(), output, out);
+            timer.stop(stats, FileStats::SERIALIZE, out.size());
+        }
+        if (cache) {
+            cache->store(key, out);
+        }
+    }
+
+    // Writes text while walking .bin, single conversion collects wanted hashes with an extra pass over view
+    void stream_text(std::span<char const> data, ritobin::io::BinCompat const* compat) {
+        auto const stats = file_stats ? &*file_stats : nullptr;
+        ritobin::io::BinView view = {};
+        if (auto error = view.open(data, compat); !error.empty()) {
+            throw std::runtime_error(error);
+        }
+        BinUnhasher const* names = nullptr;
+        if (!keep_hashed) {
+            auto timer = FileStats::Timer { jobs == 1 };
+            if (recursive || !serve.empty()) {
+                load_hashes();
+            } else {
+                load_hashes([&](BinUnhasher& uh) { uh.collect_view(view); });
+            }
+            timer.stop(stats, FileStats::LOAD_HASHES, 0);
+            names = &**unhasher;
+        }
+        auto timer = FileStats::Timer { jobs == 1 };
+        // Text goes to temporary file first so malformed input leaves no partial output behind
+        auto const temp = output_file == "-" ? output_file : output_file + ".tmp";
+        auto file = open_file<'w'>(temp);
+        if (log) {
+            log_line("Streaming...");
+        }
+        auto unhash_stats = ritobin::UnhashStats {};
+        auto error = std::string {};
+        {
+            auto const scope = unhash_stats.scope();
+            error = ritobin::io::write_text(view, file, names, 4);
+        }
+        auto const size = ftell(file);
+        fflush(file);
+        if (file != stdout) {
+            fclose(file);
+            if (!error.empty()) {
+                auto ec = std::error_code{};
+                fs::remove(temp, ec);
+            } else {
+                fs::rename(temp, output_file);
+            }
+        }
+        if (!error.empty()) {
+            throw std::runtime_error(error);
+        }
+        timer.stop(stats, FileStats::SERIALIZE, size > 0 ? static_cast<size_t>(size) : 0);
+        if (stats) {
+            stats->unhash.add(unhash_stats);
+        }
+    }
+
+    bool run_once() {
+        if (stats) {
+            file_stats.emplace(FileStats { input_file, 1 });
+        }
         try {
-            auto bin = Bin{};
-            read(bin);
-            write(bin);
-        } catch (const std::runtime_error& err) {
-            std::cerr << "In: " << input_file << std::endl;
-            std::cerr << "Out: " << output_file << std::endl;
-            std::cerr << "Error: " << err.what() << std::endl;
+            auto const stats = file_stats ? &*file_stats : nullptr;
+            auto timer = FileStats::Timer { jobs == 1 };
+            auto const data = read_data();
+            timer.stop(stats, FileStats::READ, data.size());
+            auto const input = read_format({data.data(), data.size()});
+            auto const output = write_format();
+            if (stream && !cache && output->name() == "text") {
+                if (auto const compat = ritobin::io::BinCompat::get(input->name())) {
+                    stream_text(data, compat);
+                    if (stats) {
+                        this->stats->add(std::move(*file_stats));
+                    }
+                    return true;
+                }
+            }
+            auto out = std::vector<char>{};
+            convert(data, input, output, out);
+            timer = FileStats::Timer { jobs == 1 };
+            write_data(out);
+            timer.stop(stats, FileStats::WRITE, out.size());
+            if (stats) {
+                this->stats->add(std::move(*file_stats));
+            }
+            return true;
+        } catch (const std::exception& err) {
+            report_error(err);
+            return false;
+        }
+    }
+
+    // Errors of single file, other files keep converting
+    void report_error(std::exception const& err) {
+        log_line("In: ", input_file, "\nOut: ", output_file, "\nError: ", err.what());
+    }
+
+    // Runs conversion of one file in recursive run, skipping it when manifest says it did not change
+    void run_file(fs::path const& path) {
+        if (!manifest) {
+            run_once();
+            return;
+        }
+        auto relative = std::string{};
+        auto entry = Manifest::Entry{};
+        try {
+            relative = fs::relative(path, input_dir).generic_string();
+            // Recursive runs always have input format so nothing needs to be read for detection
+            auto const input = read_format("");
+            auto const settings = settings_key(input, write_format());
+            entry = Manifest::stat(path, settings);
+            if (manifest->unchanged(relative, entry) && fs::exists(output_file)) {
+                if (log) {
+                    log_line("Unchanged: ", relative);
+                }
+                return;
+            }
+        } catch (const std::exception& err) {
+            report_error(err);
+            return;
+        }
+        if (run_once()) {
+            manifest->update(relative, std::move(entry));
         }
     }
 
+    // Request header: id input-format output-format data size, followed by size bytes of input
+    //                 id input-format output-format file path
+    // Response header: id ok size or id error size, followed by size bytes of output or error message
+    // Formats can be - to guess input and use oposite output, requests of one client may complete out of order.
+    // Connection is closed after data request that can not be read or header line that is too long,
+    // since rest of stream can not be trusted.
+    void serve_client(std::shared_ptr<Connection> client, WorkQueue& workers) {
+        auto line = std::string{};
+        while (client->read_line(line)) {
+            auto id = std::string{};
+            try {
+                auto stream = std::istringstream(line);
+                auto request = Args { *this };
+                auto source = std::string{};
+                stream >> id >> request.input_format >> request.output_format >> source;
+                for (auto format: { &request.input_format, &request.output_format }) {
+                    if (*format == "-") {
+                        format->clear();
+                    }
+                }
+                request.jobs = 1;
+                request.output_file.clear();
+                auto data = std::make_shared<std::vector<char>>();
+                if (source == "data") {
+                    size_t size = 0;
+                    if (!(stream >> size) || size > Connection::max_data_size) {
+                        client->respond(id, false, std::string_view("Invalid request data size: " + line));
+                        return;
+                    }
+                    if (!client->read_data(*data, size)) {
+                        client->respond(id, false, std::string_view("Truncated request data"));
+                        return;
+                    }
+                    request.input_file = "-";
+                } else if (source == "file" && stream.get() == ' ') {
+                    std::getline(stream, request.input_file);
+                } else {
+                    client->respond(id, false, std::string_view("Invalid request: " + line));
+                    continue;
+                }
+                workers.push([client, request = std::move(request), data, id]() mutable {
+                    request.serve_request(*client, id, *data);
+                });
+            } catch (const std::exception& err) {
+                client->respond(id, false, std::string_view(err.what()));
+                return;
+            }
+        }
+        if (line.size() == Connection::max_line_size) {
+            client->respond("-", false, std::string_view("Request header too long"));
+        }
+    }
+
+    void serve_request(Connection& client, std::string const& id, std::vector<char>& data) {
+        auto out = std::vector<char>{};
+        try {
+            if (log) {
+                log_line("Request ", id, ": ", input_file);
+            }
+            auto file = MappedFile{};
+            auto input_data = std::span<char const>(data);
+            if (input_file != "-") {
+                input_data = file = read_data();
+            }
+            auto const input = read_format({input_data.data(), input_data.size()});
+            auto const output = write_format();
+            convert(input_data, input, output, out);
+        } catch (const std::exception& err) {
+            auto const message = std::string_view(err.what());
+            client.respond(id, false, message);
+            return;
+        }
+        client.respond(id, true, out);
+    }
+
+    // Clients served at once, further connections are closed right away
+    static inline constexpr size_t max_clients = 64;
+
+    void run_serve() {
+#ifndef WIN32
+        // Clients that go away before their response is written must not take server down
+        signal(SIGPIPE, SIG_IGN);
+#endif
+        if (!keep_hashed) {
+            load_hashes();
+        }
+        auto workers = WorkQueue { jobs };
+        if (serve == "-") {
+            set_binary_mode(stdin);
+            set_binary_mode(stdout);
+            serve_client(std::make_shared<Connection>(stdin, stdout), workers);
+            return;
+        }
+#ifdef WIN32
+        throw std::runtime_error("Serving on unix socket is not supported on this platform, use --serve -");
+#else
+        auto address = sockaddr_un {};
+        address.sun_family = AF_UNIX;
+        if (serve.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + serve);
+        }
+        memcpy(address.sun_path, serve.data(), serve.size());
+        auto const server = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (server == -1) {
+            throw std::runtime_error("Failed to create socket!");
+        }
+        unlink(serve.c_str());
+        // Clients can make server read and write any file it can reach, so only owner may connect
+        auto const mask = umask(0177);
+        auto const bound = bind(server, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == 0;
+        umask(mask);
+        if (!bound || chmod(serve.c_str(), 0600) != 0 || listen(server, 16) != 0) {
+            close(server);
+            throw std::runtime_error("Failed to listen on socket: " + serve);
+        }
+        if (log) {
+            log_line("Listening on: ", serve);
+        }
+        auto clients = std::atomic<size_t> { 0 };
+        for (;;) {
+            auto const fd = accept(server, nullptr, nullptr);
+            if (fd == -1) {
+                continue;
+            }
+            if (clients >= max_clients) {
+                if (log) {
+                    log_line("Too many clients, closing connection");
+                }
+                close(fd);
+                continue;
+            }
+            auto const input = fdopen(fd, "rb");
+            auto const output = fdopen(dup(fd), "wb");
+            if (!input || !output) {
+                input ? fclose(input) : close(fd);
+                continue;
+            }
+            try {
+                clients++;
+                std::thread([this, client = std::make_shared<Connection>(input, output), &workers, &clients] {
+                    serve_client(client, workers);
+                    clients--;
+                }).detach();
+            } catch (const std::exception& err) {
+                clients--;
+                log_line("Failed to start client: ", err.what());
+            }
+        }
+#endif
+    }
+
     void run() {
+        if (crack_hashes) {
+            return crack();
+        }
+        if (!serve.empty()) {
+            return run_serve();
+        }
+        if (compile_hashes) {
+            compile();
+            if (input_file.empty() && input_dir.empty()) {
+                return;
+            }
+        }
         if (!recursive) {
-            return run_once();
+            run_once();
+            if (stats) {
+                stats->print();
+            }
+            return;
         }
 
         if (!fs::exists(input_dir) || !fs::is_directory(input_dir)) {
@@ -253,6 +1326,39 @@ struct Args {
             throw std::runtime_error("Format must have default extension!");
         }
 
+        if (skip_unchanged) {
+            manifest = std::make_shared<Manifest>();
+            manifest->load(output_dir.empty() ? input_dir : output_dir);
+        }
+
+        if (jobs <= 1) {
+            for (auto const& entry: fs::recursive_directory_iterator(input_dir)) {
+                if (!entry.is_regular_file()) {
+                    continue;
+                }
+                auto const path = entry.path();
+                if (path.extension() != extension) {
+                    continue;
+                }
+                this->input_file = path.generic_string();
+                Args {*this}.run_file(path);
+            }
+        } else {
+            run_parallel(extension);
+        }
+
+        if (manifest) {
+            manifest->save();
+        }
+        if (stats) {
+            stats->print();
+        }
+    }
+
+    // Converts files on a pool of jobs threads while this thread keeps walking the directory.
+    // Every file is converted with single job, files themselves are what runs in parallel.
+    void run_parallel(std::string_view extension) {
+        auto workers = WorkQueue { jobs };
         for (auto const& entry: fs::recursive_directory_iterator(input_dir)) {
             if (!entry.is_regular_file()) {
                 continue;
@@ -261,8 +1367,12 @@ struct Args {
             if (path.extension() != extension) {
                 continue;
             }
-            this->input_file = path.generic_string();
-            Args {*this}.run_once();
+            auto args = Args { *this };
+            args.input_file = path.generic_string();
+            args.jobs = 1;
+            workers.push([args = std::move(args), path]() mutable {
+                args.run_file(path);
+            });
         }
     }
 };
@@ -0,0 +1,112 @@
+#ifndef BIN_ALLOC_STATS_HPP
+#define BIN_ALLOC_STATS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Replaces global operator new and delete to count heap allocations of whole program.
+// Defines replacement functions, so it has to be included by exactly one translation unit of executable.
+namespace ritobin::alloc_stats {
+    // Allocations are only counted while this is set
+    inline bool enabled = false;
+    // Allocations and bytes ever allocated
+    inline std::atomic<size_t> count = 0;
+    inline std::atomic<size_t> bytes = 0;
+    // Bytes currently allocated and highest value of that since reset_peak()
+    inline std::atomic<size_t> live = 0;
+    inline std::atomic<size_t> peak = 0;
+    // Same as count and bytes but only for calling thread
+    inline thread_local constinit size_t thread_count = 0;
+    inline thread_local constinit size_t thread_bytes = 0;
+
+    // Every block starts with counted size, 0 when it was allocated while counting was off
+    inline constexpr size_t header = 16;
+
+    inline size_t add(size_t size) noexcept {
+        if (!enabled) {
+            return 0;
+        }
+        count.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        thread_count += 1;
+        thread_bytes += size;
+        auto const now = live.fetch_add(size, std::memory_order_relaxed) + size;
+        for (auto old = peak.load(std::memory_order_relaxed); old < now && !peak.compare_exchange_weak(old, now);) {}
+        return size;
+    }
+
+    inline void remove(void const* base) noexcept {
+        size_t size = 0;
+        memcpy(&size, base, sizeof(size));
+        if (size) {
+            live.fetch_sub(size, std::memory_order_relaxed);
+        }
+    }
+
+    // Starts measuring peak from current live bytes
+    inline size_t reset_peak() noexcept {
+        auto const now = live.load();
+        peak = now;
+        return now;
+    }
+
+    inline void* allocate(size_t size, size_t alignment) {
+        // Header takes one alignment unit so pointer handed out stays aligned
+        alignment = std::max(alignment, header);
+        auto const total = (size + alignment * 2 - 1) / alignment * alignment;
+#ifdef _WIN32
+        auto const base = static_cast<char*>(_aligned_malloc(total, alignment));
+#else
+        auto const base = static_cast<char*>(alignment == header ? malloc(total) : aligned_alloc(alignment, total));
+#endif
+        if (!base) {
+            throw std::bad_alloc{};
+        }
+        auto const counted = add(size);
+        memcpy(base, &counted, sizeof(counted));
+        return base + alignment;
+    }
+
+    inline void deallocate(void* ptr, size_t alignment) noexcept {
+        if (!ptr) {
+            return;
+        }
+        auto const base = static_cast<char*>(ptr) - std::max(alignment, header);
+        remove(base);
+#ifdef _WIN32
+        _aligned_free(base);
+#else
+        free(base);
+#endif
+    }
+}
+
+void* operator new(size_t size) {
+    return ritobin::alloc_stats::allocate(size, ritobin::alloc_stats::header);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    return ritobin::alloc_stats::allocate(size, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr) noexcept {
+    ritobin::alloc_stats::deallocate(ptr, ritobin::alloc_stats::header);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept {
+    ritobin::alloc_stats::deallocate(ptr, static_cast<size_t>(align));
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept {
+    operator delete(ptr, align);
+}
+
+#endif // BIN_ALLOC_STATS_HPP
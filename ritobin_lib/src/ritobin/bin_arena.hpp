@@ -0,0 +1,78 @@
+#ifndef BIN_ARENA_HPP
+#define BIN_ARENA_HPP
+
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ritobin {
+    // Makes value containers created on this thread allocate from resource while in scope.
+    struct BinArenaScope {
+        explicit BinArenaScope(std::pmr::memory_resource* resource) noexcept
+            : previous_(std::exchange(current_, resource)) {}
+        BinArenaScope(BinArenaScope const&) = delete;
+        BinArenaScope& operator=(BinArenaScope const&) = delete;
+        ~BinArenaScope() noexcept { current_ = previous_; }
+
+        static std::pmr::memory_resource* current() noexcept {
+            return current_ ? current_ : std::pmr::get_default_resource();
+        }
+    private:
+        static inline thread_local std::pmr::memory_resource* current_ = nullptr;
+        std::pmr::memory_resource* previous_;
+    };
+
+    // Monotonic arena of one tree, every extra thread filling the tree gets its own buffer from fork().
+    // Arena and its forks compare equal, so containers move between them without copying,
+    // and all of them are released together with arena.
+    struct BinArena : std::pmr::memory_resource {
+        explicit BinArena(size_t initial_size = 64 * 1024) noexcept : root_(this), buffer_(initial_size) {}
+        BinArena(BinArena const&) = delete;
+        BinArena& operator=(BinArena const&) = delete;
+
+        // Arena for one more thread, safe to call from any thread using this arena or its forks
+        BinArena* fork() {
+            auto fork = std::unique_ptr<BinArena>(new BinArena(root_, fork_size));
+            auto guard = std::lock_guard { root_->lock_ };
+            return root_->forks_.emplace_back(std::move(fork)).get();
+        }
+    private:
+        static inline constexpr size_t fork_size = 16 * 1024;
+
+        BinArena(BinArena* root, size_t initial_size) noexcept : root_(root), buffer_(initial_size) {}
+
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            return buffer_.allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void*, size_t, size_t) noexcept override {}
+
+        bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+            auto const arena = dynamic_cast<BinArena const*>(&other);
+            return arena && arena->root_ == root_;
+        }
+
+        BinArena* root_;
+        std::pmr::monotonic_buffer_resource buffer_;
+        std::mutex lock_;
+        std::vector<std::unique_ptr<BinArena>> forks_;
+    };
+
+    // Allocator of value containers, default constructed and copied ones use BinArenaScope::current().
+    template<typename T>
+    struct BinAllocator : std::pmr::polymorphic_allocator<T> {
+        BinAllocator() noexcept : std::pmr::polymorphic_allocator<T>(BinArenaScope::current()) {}
+        BinAllocator(std::pmr::memory_resource* resource) noexcept : std::pmr::polymorphic_allocator<T>(resource) {}
+        template<typename U>
+        BinAllocator(BinAllocator<U> const& other) noexcept : std::pmr::polymorphic_allocator<T>(other.resource()) {}
+
+        BinAllocator select_on_container_copy_construction() const noexcept { return {}; }
+    };
+
+    using BinString = std::basic_string<char, std::char_traits<char>, BinAllocator<char>>;
+}
+
+#endif // BIN_ARENA_HPP
@@ -0,0 +1,328 @@
+#include "bin_compact.hpp"
+#include "bin_types_helper.hpp"
+
+namespace ritobin::compact_impl {
+    static inline uint64_t pack(uint64_t high, uint64_t low) noexcept {
+        return high << 32 | (low & 0xFFFFFFFFu);
+    }
+
+    static inline uint32_t high(uint64_t data) noexcept {
+        return static_cast<uint32_t>(data >> 32);
+    }
+
+    static inline uint32_t low(uint64_t data) noexcept {
+        return static_cast<uint32_t>(data);
+    }
+
+    struct Compactor {
+        CompactBin& out;
+        std::string error = {};
+
+        bool fail(std::string msg) noexcept {
+            error = std::move(msg);
+            return false;
+        }
+
+        uint32_t alloc(size_t count) noexcept {
+            auto const first = out.nodes.size();
+            out.nodes.resize(first + count);
+            return static_cast<uint32_t>(first);
+        }
+
+        uint64_t add_chars(std::string_view str) noexcept {
+            auto const offset = out.chars.size();
+            out.chars.append(str);
+            return pack(offset, str.size());
+        }
+
+        uint8_t add_name(FNV1a const& value, uint8_t flag) noexcept {
+            if (value.str().empty()) {
+                return 0;
+            }
+            if (!out.fnv1a_names.contains(value.hash())) {
+                out.fnv1a_names.emplace(value.hash(), add_chars(value.str()));
+            }
+            return flag;
+        }
+
+        uint8_t add_name(XXH64 const& value, uint8_t flag) noexcept {
+            if (value.str().empty()) {
+                return 0;
+            }
+            if (!out.xxh64_names.contains(value.hash())) {
+                out.xxh64_names.emplace(value.hash(), add_chars(value.str()));
+            }
+            return flag;
+        }
+
+        template<typename T>
+        bool fill_items(uint32_t index, T const& items) noexcept {
+            auto const first = alloc(items.size());
+            out.nodes[index].data = pack(first, items.size());
+            if (items.packed_type() != Type::NONE) {
+                return std::visit([this, &items, first](auto&& prototype) noexcept -> bool {
+                    using item_t = std::remove_cvref_t<decltype(prototype)>;
+                    if constexpr (is_packable<item_t>) {
+                        auto const values = items.template packed<item_t>();
+                        for (size_t i = 0; i != values.size(); i++) {
+                            if (!fill(first + i, item_t { values[i] })) {
+                                return false;
+                            }
+                        }
+                    }
+                    return true;
+                }, ValueHelper::type_to_value(items.packed_type()));
+            }
+            auto i = first;
+            for (auto const& [item]: items) {
+                if (!fill(i++, item)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename T>
+        bool fill_fields(uint32_t index, T const& value) noexcept {
+            if (value.items.size() > 0xFFFFu) {
+                return fail("Too many fields in class");
+            }
+            auto const first = alloc(value.items.size());
+            auto& node = out.nodes[index];
+            node.data = pack(first, value.name.hash());
+            node.extra = static_cast<uint16_t>(value.items.size());
+            node.flags |= add_name(value.name, CompactNode::HAS_NAME);
+            for (size_t i = 0; i != value.items.size(); i++) {
+                auto const& field = value.items[i];
+                if (!fill(first + i, field.value)) {
+                    return false;
+                }
+                auto& field_node = out.nodes[first + i];
+                field_node.key = field.key.hash();
+                field_node.flags |= CompactNode::IS_FIELD | add_name(field.key, CompactNode::HAS_KEY_NAME);
+            }
+            return true;
+        }
+
+        bool fill(uint32_t index, Value const& value) noexcept {
+            return std::visit([this, index](auto const& value) noexcept -> bool {
+                using value_t = std::remove_cvref_t<decltype(value)>;
+                out.nodes[index].type = value_t::type;
+                if constexpr (std::is_same_v<value_t, None>) {
+                    return true;
+                } else if constexpr (value_t::category == Category::NUMBER || value_t::category == Category::VECTOR) {
+                    auto& node = out.nodes[index];
+                    if constexpr (sizeof(value.value) <= sizeof(node.data)) {
+                        memcpy(&node.data, &value.value, sizeof(value.value));
+                    } else {
+                        node.data = out.floats.size();
+                        out.floats.insert(out.floats.end(), value.value.begin(), value.value.end());
+                    }
+                    return true;
+                } else if constexpr (value_t::category == Category::STRING) {
+                    out.nodes[index].data = add_chars(value.value);
+                    return true;
+                } else if constexpr (value_t::category == Category::HASH) {
+                    auto& node = out.nodes[index];
+                    node.data = value.value.hash();
+                    node.flags |= add_name(value.value, CompactNode::HAS_NAME);
+                    return true;
+                } else if constexpr (value_t::category == Category::MAP) {
+                    auto const first = alloc(value.items.size() * 2);
+                    auto& node = out.nodes[index];
+                    node.data = pack(first, value.items.size());
+                    node.extra = static_cast<uint16_t>(static_cast<uint8_t>(value.keyType)
+                                                       | static_cast<uint8_t>(value.valueType) << 8);
+                    for (size_t i = 0; i != value.items.size(); i++) {
+                        if (!fill(first + i * 2, value.items[i].key)) {
+                            return false;
+                        }
+                        if (!fill(first + i * 2 + 1, value.items[i].value)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                } else if constexpr (value_t::category == Category::CLASS) {
+                    return fill_fields(index, value);
+                } else {
+                    out.nodes[index].extra = static_cast<uint8_t>(value.valueType);
+                    return fill_items(index, value.items);
+                }
+            }, value);
+        }
+    };
+
+    struct Expander {
+        CompactBin const& bin;
+
+        bool expand(CompactNode const& node, Value& value) const noexcept {
+            value = ValueHelper::type_to_value(node.type);
+            return std::visit([this, &node](auto& value) noexcept -> bool {
+                using value_t = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<value_t, None>) {
+                    return node.type == Type::NONE;
+                } else if constexpr (value_t::category == Category::NUMBER || value_t::category == Category::VECTOR) {
+                    if constexpr (sizeof(value.value) <= sizeof(node.data)) {
+                        memcpy(&value.value, &node.data, sizeof(value.value));
+                    } else {
+                        auto const floats = bin.vector(node);
+                        if (floats.size() != value.value.size()) {
+                            return false;
+                        }
+                        std::copy(floats.begin(), floats.end(), value.value.begin());
+                    }
+                    return true;
+                } else if constexpr (value_t::category == Category::STRING) {
+                    value.value = bin.string(node);
+                    return true;
+                } else if constexpr (value_t::category == Category::HASH) {
+                    expand_hash(value.value, node.data, bin.name(node));
+                    return true;
+                } else if constexpr (value_t::category == Category::MAP) {
+                    value.keyType = static_cast<Type>(node.extra & 0xFF);
+                    value.valueType = static_cast<Type>(node.extra >> 8);
+                    auto const children = bin.children(node);
+                    value.items.resize(children.size() / 2);
+                    for (size_t i = 0; i != value.items.size(); i++) {
+                        if (!expand(children[i * 2], value.items[i].key)) {
+                            return false;
+                        }
+                        if (!expand(children[i * 2 + 1], value.items[i].value)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                } else if constexpr (value_t::category == Category::CLASS) {
+                    expand_hash(value.name, low(node.data), bin.name(node));
+                    auto const children = bin.children(node);
+                    value.items.resize(children.size());
+                    for (size_t i = 0; i != children.size(); i++) {
+                        auto const& child = children[i];
+                        auto& field = value.items[i];
+                        expand_hash(field.key, child.key, bin.key_name(child));
+                        if (!expand(child, field.value)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                } else {
+                    value.valueType = static_cast<Type>(node.extra);
+                    auto const children = bin.children(node);
+                    value.items.resize(children.size());
+                    for (size_t i = 0; i != children.size(); i++) {
+                        if (!expand(children[i], value.items[i].value)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+            }, value);
+        }
+
+        template<typename T, typename H>
+        static void expand_hash(T& value, H hash, std::string_view name) noexcept {
+            if (name.empty()) {
+                value = static_cast<typename T::storage_t>(hash);
+            } else {
+                value = std::string(name);
+            }
+        }
+    };
+}
+
+namespace ritobin {
+    using namespace compact_impl;
+
+    std::span<CompactNode const> CompactBin::children(CompactNode const& node) const noexcept {
+        switch (node.type) {
+        case Type::LIST:
+        case Type::LIST2:
+        case Type::OPTION:
+            return { nodes.data() + high(node.data), low(node.data) };
+        case Type::MAP:
+            return { nodes.data() + high(node.data), size_t{ low(node.data) } * 2 };
+        case Type::POINTER:
+        case Type::EMBED:
+            return { nodes.data() + high(node.data), node.extra };
+        default:
+            return {};
+        }
+    }
+
+    std::string_view CompactBin::string(CompactNode const& node) const noexcept {
+        if (node.type != Type::STRING) {
+            return {};
+        }
+        return { chars.data() + high(node.data), low(node.data) };
+    }
+
+    std::string_view CompactBin::name(CompactNode const& node) const noexcept {
+        if (!(node.flags & CompactNode::HAS_NAME)) {
+            return {};
+        }
+        auto const location = node.type == Type::FILE
+            ? xxh64_names.find(node.data)->second
+            : fnv1a_names.find(low(node.data))->second;
+        return { chars.data() + high(location), low(location) };
+    }
+
+    std::string_view CompactBin::key_name(CompactNode const& node) const noexcept {
+        if (!(node.flags & CompactNode::HAS_KEY_NAME)) {
+            return {};
+        }
+        auto const location = fnv1a_names.find(node.key)->second;
+        return { chars.data() + high(location), low(location) };
+    }
+
+    std::span<float const> CompactBin::vector(CompactNode const& node) const noexcept {
+        switch (node.type) {
+        case Type::VEC3:
+            return { floats.data() + node.data, 3 };
+        case Type::VEC4:
+            return { floats.data() + node.data, 4 };
+        case Type::MTX44:
+            return { floats.data() + node.data, 16 };
+        default:
+            return {};
+        }
+    }
+
+    size_t CompactBin::memory_usage() const noexcept {
+        constexpr size_t table_entry = sizeof(void*) * 2 + sizeof(uint64_t) * 2;
+        size_t result = 0;
+        for (auto const& [name, root]: sections) {
+            result += sizeof(name) + name.capacity() + sizeof(root);
+        }
+        result += nodes.capacity() * sizeof(CompactNode);
+        result += floats.capacity() * sizeof(float);
+        result += chars.capacity();
+        result += (fnv1a_names.size() + xxh64_names.size()) * table_entry;
+        result += (fnv1a_names.bucket_count() + xxh64_names.bucket_count()) * sizeof(void*);
+        return result;
+    }
+
+    std::string compact_bin(CompactBin& out, Bin const& bin) noexcept {
+        out = {};
+        auto compactor = Compactor { out };
+        for (auto const& [name, value]: bin.sections) {
+            auto const index = compactor.alloc(1);
+            out.sections.emplace_back(name, index);
+            if (!compactor.fill(index, value)) {
+                return compactor.error;
+            }
+        }
+        return {};
+    }
+
+    std::string expand_bin(Bin& out, CompactBin const& bin) noexcept {
+        out.sections.clear();
+        auto expander = Expander { bin };
+        for (auto const& [name, index]: bin.sections) {
+            auto& value = out.sections[name];
+            if (index >= bin.nodes.size() || !expander.expand(bin.nodes[index], value)) {
+                return "Failed to expand section: " + name;
+            }
+        }
+        return {};
+    }
+}
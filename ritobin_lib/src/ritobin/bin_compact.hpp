@@ -0,0 +1,67 @@
+#ifndef BIN_COMPACT_HPP
+#define BIN_COMPACT_HPP
+
+#include <span>
+#include "bin_types.hpp"
+
+namespace ritobin {
+    // Fixed 16 byte node, anything that does not fit is kept out of line in CompactBin pools.
+    //
+    // data layout by type:
+    //  - numbers, bool, flag, vec2, rgba: value stored inline
+    //  - vec3, vec4, mtx44: offset into floats
+    //  - string: offset << 32 | size into chars
+    //  - hash, link, file: hash stored inline, name looked up in names table when HAS_NAME is set
+    //  - list, list2, option: first << 32 | count of child nodes
+    //  - map: first << 32 | count of pairs, pairs are stored as key node followed by value node
+    //  - embed, pointer: first << 32 | class name hash, field count is in extra
+    struct CompactNode {
+        static inline constexpr uint8_t HAS_NAME = 1;
+        static inline constexpr uint8_t HAS_KEY_NAME = 2;
+        static inline constexpr uint8_t IS_FIELD = 4;
+
+        Type type = {};
+        uint8_t flags = {};
+        // list, list2, option: value type
+        // map: key type | value type << 8
+        // embed, pointer: number of fields
+        uint16_t extra = {};
+        // field key hash
+        uint32_t key = {};
+        uint64_t data = {};
+    };
+    static_assert(sizeof(CompactNode) == 16);
+
+    struct CompactBin {
+        std::vector<std::pair<std::string, uint32_t>> sections;
+        std::vector<CompactNode> nodes;
+        std::vector<float> floats;
+        std::string chars;
+        // Names are shared by every node with same hash, value is offset << 32 | size into chars
+        std::unordered_map<uint32_t, uint64_t> fnv1a_names;
+        std::unordered_map<uint64_t, uint64_t> xxh64_names;
+
+        CompactNode const& root(size_t section) const noexcept {
+            return nodes[sections[section].second];
+        }
+
+        // Items of list, list2 and option, key/value pairs of map and fields of embed and pointer
+        std::span<CompactNode const> children(CompactNode const& node) const noexcept;
+        // Value of string
+        std::string_view string(CompactNode const& node) const noexcept;
+        // Unhashed value of hash, link, file or class name of embed and pointer
+        std::string_view name(CompactNode const& node) const noexcept;
+        // Unhashed field key
+        std::string_view key_name(CompactNode const& node) const noexcept;
+        // Components of vec2, vec3, vec4 and mtx44
+        std::span<float const> vector(CompactNode const& node) const noexcept;
+        // Bytes held by nodes and pools
+        size_t memory_usage() const noexcept;
+    };
+
+    extern std::string compact_bin(CompactBin& out, Bin const& bin) noexcept;
+
+    extern std::string expand_bin(Bin& out, CompactBin const& bin) noexcept;
+}
+
+#endif // BIN_COMPACT_HPP
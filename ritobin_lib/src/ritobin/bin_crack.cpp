@@ -0,0 +1,247 @@
+#include "bin_crack.hpp"
+#include "bin_mmap.hpp"
+#include "bin_parallel.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace ritobin::crack_impl {
+    static inline bool is_upper(char c) noexcept {
+        return c >= 'A' && c <= 'Z';
+    }
+
+    static inline bool is_lower(char c) noexcept {
+        return c >= 'a' && c <= 'z';
+    }
+
+    static inline bool is_digit(char c) noexcept {
+        return c >= '0' && c <= '9';
+    }
+
+    static inline char to_lower(char c) noexcept {
+        return is_upper(c) ? c - 'A' + 'a' : c;
+    }
+
+    static inline char to_upper(char c) noexcept {
+        return is_lower(c) ? c - 'a' + 'A' : c;
+    }
+
+    static std::string lower_str(std::string_view str) noexcept {
+        auto result = std::string(str);
+        for (auto& c: result) {
+            c = to_lower(c);
+        }
+        return result;
+    }
+
+    static inline uint32_t extend(uint32_t hash, std::string_view str) noexcept {
+        for (char c: str) {
+            hash = hash_impl::fnv1a_step(hash, c);
+        }
+        return hash;
+    }
+
+    // Bit per low 24 bits of wanted hashes rejects almost every miss before exact search
+    struct WantedFilter {
+        std::vector<uint64_t> bits = std::vector<uint64_t>(size_t{1} << 18);
+        std::vector<uint32_t> sorted;
+
+        explicit WantedFilter(std::unordered_set<uint32_t> const& wanted) noexcept
+            : sorted(wanted.begin(), wanted.end()) {
+            std::sort(sorted.begin(), sorted.end());
+            for (auto hash: sorted) {
+                auto const low = hash & 0xFFFFFFu;
+                bits[low >> 6] |= uint64_t{1} << (low & 63);
+            }
+        }
+
+        inline bool contains(uint32_t hash) const noexcept {
+            auto const low = hash & 0xFFFFFFu;
+            if (!(bits[low >> 6] >> (low & 63) & 1)) {
+                return false;
+            }
+            return std::binary_search(sorted.begin(), sorted.end(), hash);
+        }
+    };
+
+    // Depth first walk over word sequences, state of every prefix is computed once
+    struct Search {
+        HashCracker const& cracker;
+        std::vector<std::string> const& words;
+        WantedFilter const& filter;
+        std::string const& prefix;
+        std::vector<size_t> path = {};
+        std::vector<std::pair<uint32_t, std::string>> found = {};
+
+        void visit(uint32_t state) noexcept {
+            for (auto const& suffix: cracker.suffixes) {
+                auto const hash = extend(state, suffix);
+                if (filter.contains(hash)) {
+                    found.emplace_back(hash, name(suffix));
+                }
+            }
+            if (path.size() >= cracker.max_words) {
+                return;
+            }
+            for (size_t i = 0; i != words.size(); i++) {
+                path.push_back(i);
+                visit(extend(state, words[i]));
+                path.pop_back();
+            }
+        }
+
+        std::string name(std::string const& suffix) const noexcept {
+            auto result = prefix;
+            for (auto i: path) {
+                auto const& word = words[i];
+                result += cracker.camel_case ? to_upper(word.front()) : word.front();
+                result.append(word, 1);
+            }
+            result += suffix;
+            return result;
+        }
+    };
+
+    // Words that only differ in case hash the same, first spelling is kept
+    static std::vector<std::string> unique_words(std::vector<std::string> const& words) noexcept {
+        auto seen = std::unordered_set<std::string> {};
+        auto result = std::vector<std::string> {};
+        for (auto const& word: words) {
+            if (!word.empty() && seen.insert(lower_str(word)).second) {
+                result.push_back(word);
+            }
+        }
+        return result;
+    }
+}
+
+namespace ritobin {
+    using namespace crack_impl;
+
+    void HashCracker::add_words(std::string_view name) noexcept {
+        size_t start = 0;
+        auto const flush = [&](size_t end) {
+            if (end > start) {
+                words.emplace_back(name.substr(start, end - start));
+            }
+        };
+        for (size_t i = 0; i != name.size(); i++) {
+            auto const c = name[i];
+            if (!is_upper(c) && !is_lower(c) && !is_digit(c)) {
+                flush(i);
+                start = i + 1;
+                continue;
+            }
+            if (i == start) {
+                continue;
+            }
+            auto const prev = name[i - 1];
+            auto const next = i + 1 != name.size() ? name[i + 1] : '\0';
+            auto const boundary = (is_upper(c) && (is_lower(prev) || is_digit(prev)))
+                                  || (is_upper(c) && is_upper(prev) && is_lower(next))
+                                  || (is_digit(c) != is_digit(prev));
+            if (boundary) {
+                // Leading single lower case letter is member prefix like "m" or "b", prefixes cover it
+                if (!(start == 0 && i == 1 && is_lower(prev))) {
+                    flush(i);
+                }
+                start = i;
+            }
+        }
+        flush(name.size());
+    }
+
+    bool HashCracker::load_words(std::string const& filename) noexcept {
+        auto file = fopen(filename.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        MappedFile data = {};
+        auto const ok = data.map(file);
+        fclose(file);
+        if (!ok) {
+            return false;
+        }
+        // Every name gets split so same words from many lines are only added once
+        auto seen = std::unordered_set<std::string> {};
+        for (auto const& word: words) {
+            seen.insert(lower_str(word));
+        }
+        for (auto rest = std::string_view{ data.data(), data.size() }; !rest.empty();) {
+            auto const end = std::min(rest.find('\n'), rest.size());
+            auto line = rest.substr(0, end);
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (auto const space = line.rfind(' '); space != std::string_view::npos) {
+                line.remove_prefix(space + 1);
+            }
+            auto const before = words.size();
+            add_words(line);
+            size_t kept = before;
+            for (size_t i = before; i != words.size(); i++) {
+                if (seen.insert(lower_str(words[i])).second) {
+                    if (kept != i) {
+                        words[kept] = std::move(words[i]);
+                    }
+                    kept++;
+                }
+            }
+            words.resize(kept);
+        }
+        return true;
+    }
+
+    size_t HashCracker::candidate_count() const noexcept {
+        auto const word_count = unique_words(words).size();
+        size_t total = 0;
+        size_t level = 1;
+        for (size_t i = 0; i != max_words; i++) {
+            level *= word_count;
+            total += level;
+        }
+        return total * prefixes.size() * suffixes.size();
+    }
+
+    std::map<uint32_t, std::string> HashCracker::crack() const noexcept {
+        auto result = std::map<uint32_t, std::string> {};
+        auto const unique = unique_words(words);
+        if (wanted.empty() || unique.empty() || max_words == 0) {
+            return result;
+        }
+        auto const filter = WantedFilter { wanted };
+        // One work item per prefix and first word, every item keeps its own matches
+        auto const count = prefixes.size() * unique.size();
+        auto found = std::vector<std::vector<std::pair<uint32_t, std::string>>>(count);
+        parallel_for(count, jobs, [&](size_t i) noexcept {
+            auto const& prefix = prefixes[i / unique.size()];
+            auto const first = i % unique.size();
+            auto search = Search { *this, unique, filter, prefix };
+            search.path.push_back(first);
+            search.visit(extend(extend(0x811c9dc5, prefix), unique[first]));
+            found[i] = std::move(search.found);
+            return true;
+        });
+        for (auto const& matches: found) {
+            for (auto const& [hash, name]: matches) {
+                result.emplace(hash, name);
+            }
+        }
+        return result;
+    }
+
+    bool HashCracker::save_CDTB(std::string const& filename, std::map<uint32_t, std::string> const& names) noexcept {
+        auto file = filename == "-" ? stdout : fopen(filename.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        for (auto const& [hash, name]: names) {
+            fprintf(file, "%08x %s\n", hash, name.c_str());
+        }
+        auto const ok = fflush(file) == 0;
+        if (file != stdout) {
+            fclose(file);
+        }
+        return ok;
+    }
+}
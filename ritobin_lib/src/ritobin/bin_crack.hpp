@@ -0,0 +1,40 @@
+#ifndef BIN_CRACK_HPP
+#define BIN_CRACK_HPP
+
+#include "bin_hash.hpp"
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace ritobin {
+    // Finds names for FNV1a hashes by hashing generated candidates.
+    //
+    // Candidates are prefix + 1 to max_words words + suffix, words may repeat.
+    // FNV1a ignores case so casing only matters for how found names are written out,
+    // with camel_case set every word starts with upper case letter ("m" + "SpellData").
+    // Hash state after prefix and every partial run of words is reused by all longer candidates.
+    struct HashCracker {
+        std::unordered_set<uint32_t> wanted;
+        std::vector<std::string> words;
+        // Empty string means candidate without prefix or suffix
+        std::vector<std::string> prefixes = { "", "m" };
+        std::vector<std::string> suffixes = { "" };
+        size_t max_words = 2;
+        bool camel_case = true;
+        size_t jobs = 1;
+
+        // Splits identifier or path into words ("mVFXSystem_2" gives "VFX", "System", "2")
+        void add_words(std::string_view name) noexcept;
+        // Adds words of last space separated token on every line, works on wordlists and CDTB files
+        bool load_words(std::string const& filename) noexcept;
+        // Tries every candidate on up to jobs threads, when hash matches more than one candidate first one wins
+        std::map<uint32_t, std::string> crack() const noexcept;
+        // Number of candidates crack() would try
+        size_t candidate_count() const noexcept;
+
+        static bool save_CDTB(std::string const& filename, std::map<uint32_t, std::string> const& names) noexcept;
+    };
+}
+
+#endif // BIN_CRACK_HPP
@@ -1,91 +1,176 @@
 #include "bin_hash.hpp"
-#include <bit>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
-uint32_t ritobin::FNV1a::fnv1a(std::string_view str) noexcept {
-    uint32_t h = 0x811c9dc5;
-    for (uint32_t c : str) {
-        c = c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
-        h = ((h ^ c) * 0x01000193) & 0xFFFFFFFF;
+namespace ritobin::hash_impl {
+    // Lower cases 8 chars in one go, only bytes in A-Z get 0x20 added
+    static inline uint64_t lower_ascii(uint64_t value) noexcept {
+        constexpr uint64_t ones = 0x0101010101010101u;
+        constexpr uint64_t high = 0x8080808080808080u;
+        auto const heptets = value & ~high;
+        auto const above_z = heptets + ones * (0x7F - 'Z');
+        auto const from_a = heptets + ones * (0x80 - 'A');
+        auto const upper = ~value & (from_a ^ above_z) & high;
+        return value | (upper >> 2);
     }
-    return h;
-}
 
-uint64_t ritobin::XXH64::xxh64(std::string_view str, uint64_t seed) noexcept {
-    auto data = str.data();
-    auto const size = str.size();
-    auto const end = data + size;
-    constexpr uint64_t Prime1 = 11400714785074694791U;
-    constexpr uint64_t Prime2 = 14029467366897019727U;
-    constexpr uint64_t Prime3 =  1609587929392839161U;
-    constexpr uint64_t Prime4 =  9650029242287828579U;
-    constexpr uint64_t Prime5 =  2870177450012600261U;
-    constexpr auto Char = [](char c) constexpr -> uint64_t {
-        return static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    struct XXH64WideLoad {
+        static uint64_t byte(char c) noexcept {
+            return xxh64_char(c);
+        }
+
+        static uint64_t half_block(char const* data) noexcept {
+            uint32_t value = 0;
+            memcpy(&value, data, sizeof(value));
+            return lower_ascii(value);
+        }
+
+        static uint64_t block(char const* data) noexcept {
+            uint64_t value = 0;
+            memcpy(&value, data, sizeof(value));
+            return lower_ascii(value);
+        }
     };
-    constexpr auto HalfBlock = [Char](char const* data) constexpr -> uint64_t {
-        return Char(*data)
-                | (Char(*(data + 1)) << 8)
-                | (Char(*(data + 2)) << 16)
-                | (Char(*(data + 3)) << 24);
+
+    struct XXH64RawLoad {
+        static uint64_t byte(char c) noexcept {
+            return static_cast<uint8_t>(c);
+        }
+
+        static uint64_t half_block(char const* data) noexcept {
+            uint32_t value = 0;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        static uint64_t block(char const* data) noexcept {
+            uint64_t value = 0;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
     };
-    constexpr auto Block = [Char](char const* data) constexpr -> uint64_t {
-        return Char(*data)
-                | (Char(*(data + 1)) << 8)
-                | (Char(*(data + 2)) << 16)
-                | (Char(*(data + 3)) << 24)
-                | (Char(*(data + 4)) << 32)
-                | (Char(*(data + 5)) << 40)
-                | (Char(*(data + 6)) << 48)
-                | (Char(*(data + 7)) << 56);
+
+    struct InternHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const noexcept {
+            return std::hash<std::string_view>{}(str);
+        }
     };
-    constexpr auto ROL = [](uint64_t value, int ammount) -> uint64_t {
-        return std::rotl(value, ammount);
+
+    // Strings this thread already got from pool with given generation, read without locking.
+    // Keys of pool that is gone are only dropped, never read.
+    struct InternCache {
+        uint64_t generation = 0;
+        std::unordered_map<std::string_view, std::string const*> strings;
     };
-    uint64_t result = 0;
-    if (size >= 32u) {
-        uint64_t s1 = seed + Prime1 + Prime2;
-        uint64_t s2 = seed + Prime2;
-        uint64_t s3 = seed;
-        uint64_t s4 = seed - Prime1;
-        for(; data + 32 <= end; data += 32) {
-            s1 = ROL(s1 + Block(data) * Prime2, 31) * Prime1;
-            s2 = ROL(s2 + Block(data + 8) * Prime2, 31) * Prime1;
-            s3 = ROL(s3 + Block(data + 16) * Prime2, 31) * Prime1;
-            s4 = ROL(s4 + Block(data + 24) * Prime2, 31) * Prime1;
-        }
-        result  = ROL(s1,  1) +
-                  ROL(s2,  7) +
-                  ROL(s3, 12) +
-                  ROL(s4, 18);
-        result ^= ROL(s1 * Prime2, 31) * Prime1;
-        result = result * Prime1 + Prime4;
-        result ^= ROL(s2 * Prime2, 31) * Prime1;
-        result = result * Prime1 + Prime4;
-        result ^= ROL(s3 * Prime2, 31) * Prime1;
-        result = result * Prime1 + Prime4;
-        result ^= ROL(s4 * Prime2, 31) * Prime1;
-        result = result * Prime1 + Prime4;
-    } else {
-        result = seed + Prime5;
-    }
-    result += static_cast<uint64_t>(size);
-    for(; data + 8 <= end; data += 8) {
-        result ^= ROL(Block(data) * Prime2, 31) * Prime1;
-        result = ROL(result, 27) * Prime1 + Prime4;
+
+    static thread_local InternCache intern_cache = {};
+
+    static std::atomic<uint64_t> intern_generation = 0;
+
+    static constexpr size_t intern_shard_count = 16;
+}
+
+// Split in shards so threads interning different strings rarely wait on each other
+struct ritobin::InternPool::Shard {
+    std::mutex lock;
+    std::unordered_set<std::string, hash_impl::InternHash, std::equal_to<>> strings;
+};
+
+ritobin::InternPool::InternPool() noexcept
+    : shards_(new Shard[hash_impl::intern_shard_count]), generation_(++hash_impl::intern_generation) {}
+
+ritobin::InternPool::~InternPool() noexcept = default;
+
+std::string const* ritobin::InternPool::intern(std::string_view str) noexcept {
+    if (str.empty()) {
+        return nullptr;
     }
-    for(; data + 4 <= end; data += 4) {
-        result ^= HalfBlock(data) * Prime1;
-        result = ROL(result, 23) * Prime2 + Prime3;
+    auto& cache = hash_impl::intern_cache;
+    if (cache.generation != generation_) {
+        cache.strings.clear();
+        cache.generation = generation_;
+    } else if (auto i = cache.strings.find(str); i != cache.strings.end()) {
+        return i->second;
     }
-    for(; data != end; ++data) {
-        result ^= Char(*data) * Prime5;
-        result = ROL(result, 11) * Prime1;
+    auto const h = hash_impl::InternHash{}(str);
+    auto& shard = shards_[h % hash_impl::intern_shard_count];
+    auto result = static_cast<std::string const*>(nullptr);
+    {
+        auto guard = std::lock_guard { shard.lock };
+        result = &*shard.strings.emplace(str).first;
     }
-    result ^= result >> 33;
-    result *= Prime2;
-    result ^= result >> 29;
-    result *= Prime3;
-    result ^= result >> 32;
+    cache.strings.emplace(*result, result);
     return result;
 }
 
+std::string const* ritobin::intern_str(std::string_view str) noexcept {
+    if (auto const pool = InternPool::Scope::current()) {
+        return pool->intern(str);
+    }
+    // Leaked on purpose, hashed values may still point into it during static destruction
+    static auto global = new InternPool{};
+    return global->intern(str);
+}
+
+uint64_t ritobin::hash_impl::xxh64_wide(std::string_view str, uint64_t seed) noexcept {
+    return xxh64<XXH64WideLoad>(str, seed);
+}
+
+uint64_t ritobin::xxh64_bytes(std::span<char const> data, uint64_t seed) noexcept {
+    return hash_impl::xxh64<hash_impl::XXH64RawLoad>({ data.data(), data.size() }, seed);
+}
+
+void ritobin::fnv1a_batch(std::span<std::string_view const> strs, std::span<uint32_t> out) noexcept {
+    using hash_impl::fnv1a_step;
+    // Four chains in plain locals, arrays of lanes get vectorized into slower emulated multiplies
+    size_t i = 0;
+    for (; strs.size() - i >= 4; i += 4) {
+        auto const s0 = strs[i];
+        auto const s1 = strs[i + 1];
+        auto const s2 = strs[i + 2];
+        auto const s3 = strs[i + 3];
+        uint32_t h0 = 0x811c9dc5;
+        uint32_t h1 = 0x811c9dc5;
+        uint32_t h2 = 0x811c9dc5;
+        uint32_t h3 = 0x811c9dc5;
+        auto const common = std::min(std::min(s0.size(), s1.size()), std::min(s2.size(), s3.size()));
+        for (size_t c = 0; c != common; c++) {
+            h0 = fnv1a_step(h0, s0[c]);
+            h1 = fnv1a_step(h1, s1[c]);
+            h2 = fnv1a_step(h2, s2[c]);
+            h3 = fnv1a_step(h3, s3[c]);
+        }
+        for (char c : s0.substr(common)) {
+            h0 = fnv1a_step(h0, c);
+        }
+        for (char c : s1.substr(common)) {
+            h1 = fnv1a_step(h1, c);
+        }
+        for (char c : s2.substr(common)) {
+            h2 = fnv1a_step(h2, c);
+        }
+        for (char c : s3.substr(common)) {
+            h3 = fnv1a_step(h3, c);
+        }
+        out[i] = h0;
+        out[i + 1] = h1;
+        out[i + 2] = h2;
+        out[i + 3] = h3;
+    }
+    for (; i != strs.size(); i++) {
+        out[i] = FNV1a::fnv1a(strs[i]);
+    }
+}
+
+void ritobin::xxh64_batch(std::span<std::string_view const> strs, std::span<uint64_t> out) noexcept {
+    // Every string is already hashed in 4 independent lanes once it is 32 chars or longer
+    for (size_t i = 0; i != strs.size(); i++) {
+        out[i] = hash_impl::xxh64_wide(strs[i], 0);
+    }
+}
@@ -1,92 +1,246 @@
 #ifndef BIN_HASH_HPP
 #define BIN_HASH_HPP
 
+#include <bit>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace ritobin {
+    // Set of shared string copies, all of them are freed together with pool.
+    // Hashed values that got their names while pool was current must not be used after it is gone.
+    struct InternPool {
+        InternPool() noexcept;
+        InternPool(InternPool const&) = delete;
+        InternPool& operator=(InternPool const&) = delete;
+        ~InternPool() noexcept;
+
+        // Returns copy of str, equal strings always get same copy.
+        // Safe to call from multiple threads, strings this thread already got from pool skip the lock.
+        std::string const* intern(std::string_view str) noexcept;
+
+        // Makes intern_str on this thread use pool while in scope
+        struct Scope {
+            explicit Scope(InternPool* pool) noexcept : previous_(std::exchange(current_, pool)) {}
+            Scope(Scope const&) = delete;
+            Scope& operator=(Scope const&) = delete;
+            ~Scope() noexcept { current_ = previous_; }
+
+            static InternPool* current() noexcept {
+                return current_;
+            }
+        private:
+            static inline thread_local InternPool* current_ = nullptr;
+            InternPool* previous_;
+        };
+
+        Scope scope() noexcept { return Scope { this }; }
+    private:
+        struct Shard;
+        std::unique_ptr<Shard[]> shards_;
+        uint64_t generation_;
+    };
+
+    // Returns shared copy of str from pool in scope on this thread.
+    // Without one copies go to global pool that is never freed.
+    extern std::string const* intern_str(std::string_view str) noexcept;
+
+    // Hashes of every string in strs written to out, which must be at least as big.
+    // Independent strings are hashed side by side so their multiplies overlap.
+    extern void fnv1a_batch(std::span<std::string_view const> strs, std::span<uint32_t> out) noexcept;
+    extern void xxh64_batch(std::span<std::string_view const> strs, std::span<uint64_t> out) noexcept;
+
+    // XXH64 of bytes as they are, without lower casing, for hashing file contents
+    extern uint64_t xxh64_bytes(std::span<char const> data, uint64_t seed = 0) noexcept;
+
     struct FNV1a {
     private:
         uint32_t hash_ = 0;
-        std::string str_ = {};
-        static uint32_t fnv1a(std::string_view str) noexcept;
+        std::string const* str_ = nullptr;
     public:
         using storage_t = uint32_t;
 
-        inline FNV1a() noexcept = default;
+        // Hash of lower cased str, names known up front can be hashed at compile time
+        static inline constexpr uint32_t fnv1a(std::string_view str) noexcept;
 
-        inline FNV1a(std::string str) noexcept : hash_(fnv1a(str)), str_(std::move(str)) {}
+        inline constexpr FNV1a() noexcept = default;
 
-        inline FNV1a(uint32_t h) noexcept : hash_(h), str_() {}
+        inline FNV1a(std::string_view str) noexcept : hash_(fnv1a(str)), str_(intern_str(str)) {}
 
-        inline FNV1a& operator=(std::string str) noexcept {
+        inline constexpr FNV1a(uint32_t h) noexcept : hash_(h), str_(nullptr) {}
+
+        inline FNV1a& operator=(std::string_view str) noexcept {
             hash_ = fnv1a(str);
-            str_ = std::move(str);
+            str_ = intern_str(str);
             return *this;
         }
 
         inline FNV1a& operator=(uint32_t h) noexcept {
             if (hash_ != h) {
                 hash_ = h;
-                str_.clear();
+                str_ = nullptr;
             }
             return *this;
         }
 
-        inline uint32_t hash() const noexcept {
+        inline constexpr uint32_t hash() const noexcept {
             return hash_;
         }
 
-        inline std::string_view str() const& noexcept {
-            return str_;
-        }
-
-        inline std::string str() && noexcept {
-            return std::move(str_);
+        inline std::string_view str() const noexcept {
+            return str_ ? std::string_view{ *str_ } : std::string_view{};
         }
     };
 
     struct XXH64 {
     private:
         uint64_t hash_ = {};
-        std::string str_ = {};
-        static uint64_t xxh64(std::string_view str, uint64_t seed = 0) noexcept;
+        std::string const* str_ = nullptr;
     public:
         using storage_t = uint64_t;
 
-        inline XXH64() noexcept = default;
+        // Hash of lower cased str, names known up front can be hashed at compile time
+        static inline constexpr uint64_t xxh64(std::string_view str, uint64_t seed = 0) noexcept;
+
+        inline constexpr XXH64() noexcept = default;
 
-        inline XXH64(std::string str) noexcept : hash_(xxh64(str)), str_(std::move(str)) {}
+        inline XXH64(std::string_view str) noexcept : hash_(xxh64(str)), str_(intern_str(str)) {}
 
-        inline XXH64(uint64_t h) noexcept : hash_(h), str_() {}
+        inline constexpr XXH64(uint64_t h) noexcept : hash_(h), str_(nullptr) {}
 
-        inline XXH64& operator=(std::string str) noexcept {
+        inline XXH64& operator=(std::string_view str) noexcept {
             hash_ = xxh64(str);
-            str_ = std::move(str);
+            str_ = intern_str(str);
             return *this;
         }
 
         inline XXH64& operator=(uint64_t h) noexcept {
             if (hash_ != h) {
                 hash_ = h;
-                str_.clear();
+                str_ = nullptr;
             }
             return *this;
         }
 
-        inline uint64_t hash() const noexcept {
+        inline constexpr uint64_t hash() const noexcept {
             return hash_;
         }
 
-        inline std::string_view str() const& noexcept {
-            return str_;
+        inline std::string_view str() const noexcept {
+            return str_ ? std::string_view{ *str_ } : std::string_view{};
+        }
+    };
+}
+
+namespace ritobin::hash_impl {
+    inline constexpr uint32_t fnv1a_step(uint32_t h, char c) noexcept {
+        uint32_t const u = static_cast<uint32_t>(c);
+        return (h ^ (u - 'A' < 26u ? u + ('a' - 'A') : u)) * 0x01000193u;
+    }
+
+    inline constexpr uint64_t xxh64_char(char c) noexcept {
+        return static_cast<uint8_t>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+
+    // Lower cased little endian blocks one char at a time, works in constant evaluation
+    struct XXH64CharLoad {
+        static constexpr uint64_t byte(char c) noexcept {
+            return xxh64_char(c);
+        }
+
+        static constexpr uint64_t half_block(char const* data) noexcept {
+            return xxh64_char(*data)
+                    | (xxh64_char(*(data + 1)) << 8)
+                    | (xxh64_char(*(data + 2)) << 16)
+                    | (xxh64_char(*(data + 3)) << 24);
         }
 
-        inline std::string str() && noexcept {
-            return std::move(str_);
+        static constexpr uint64_t block(char const* data) noexcept {
+            return half_block(data) | (half_block(data + 4) << 32);
         }
     };
+
+    template<typename Load>
+    inline constexpr uint64_t xxh64(std::string_view str, uint64_t seed) noexcept {
+        auto data = str.data();
+        auto const size = str.size();
+        auto const end = data + size;
+        constexpr uint64_t Prime1 = 11400714785074694791U;
+        constexpr uint64_t Prime2 = 14029467366897019727U;
+        constexpr uint64_t Prime3 =  1609587929392839161U;
+        constexpr uint64_t Prime4 =  9650029242287828579U;
+        constexpr uint64_t Prime5 =  2870177450012600261U;
+        uint64_t result = 0;
+        if (size >= 32u) {
+            uint64_t s1 = seed + Prime1 + Prime2;
+            uint64_t s2 = seed + Prime2;
+            uint64_t s3 = seed;
+            uint64_t s4 = seed - Prime1;
+            for(; end - data >= 32; data += 32) {
+                s1 = std::rotl(s1 + Load::block(data) * Prime2, 31) * Prime1;
+                s2 = std::rotl(s2 + Load::block(data + 8) * Prime2, 31) * Prime1;
+                s3 = std::rotl(s3 + Load::block(data + 16) * Prime2, 31) * Prime1;
+                s4 = std::rotl(s4 + Load::block(data + 24) * Prime2, 31) * Prime1;
+            }
+            result  = std::rotl(s1,  1) +
+                      std::rotl(s2,  7) +
+                      std::rotl(s3, 12) +
+                      std::rotl(s4, 18);
+            result ^= std::rotl(s1 * Prime2, 31) * Prime1;
+            result = result * Prime1 + Prime4;
+            result ^= std::rotl(s2 * Prime2, 31) * Prime1;
+            result = result * Prime1 + Prime4;
+            result ^= std::rotl(s3 * Prime2, 31) * Prime1;
+            result = result * Prime1 + Prime4;
+            result ^= std::rotl(s4 * Prime2, 31) * Prime1;
+            result = result * Prime1 + Prime4;
+        } else {
+            result = seed + Prime5;
+        }
+        result += static_cast<uint64_t>(size);
+        for(; end - data >= 8; data += 8) {
+            result ^= std::rotl(Load::block(data) * Prime2, 31) * Prime1;
+            result = std::rotl(result, 27) * Prime1 + Prime4;
+        }
+        for(; end - data >= 4; data += 4) {
+            result ^= Load::half_block(data) * Prime1;
+            result = std::rotl(result, 23) * Prime2 + Prime3;
+        }
+        for(; data != end; ++data) {
+            result ^= Load::byte(*data) * Prime5;
+            result = std::rotl(result, 11) * Prime1;
+        }
+        result ^= result >> 33;
+        result *= Prime2;
+        result ^= result >> 29;
+        result *= Prime3;
+        result ^= result >> 32;
+        return result;
+    }
+
+    // Loads whole blocks and lower cases all of their chars at once
+    extern uint64_t xxh64_wide(std::string_view str, uint64_t seed) noexcept;
+}
+
+namespace ritobin {
+    inline constexpr uint32_t FNV1a::fnv1a(std::string_view str) noexcept {
+        uint32_t h = 0x811c9dc5;
+        for (char c : str) {
+            h = hash_impl::fnv1a_step(h, c);
+        }
+        return h;
+    }
+
+    inline constexpr uint64_t XXH64::xxh64(std::string_view str, uint64_t seed) noexcept {
+        if (std::is_constant_evaluated()) {
+            return hash_impl::xxh64<hash_impl::XXH64CharLoad>(str, seed);
+        }
+        return hash_impl::xxh64_wide(str, seed);
+    }
 }
 
 #endif // BIN_HASH_HPP
@@ -19,8 +19,8 @@ namespace ritobin::io {
         virtual std::string_view oposite_name() const noexcept = 0;
         virtual std::string_view default_extension() const noexcept = 0;
         virtual bool output_allways_hashed() const noexcept = 0;
-        virtual std::string read(ritobin::Bin& bin, std::span<char const> data) const = 0;
-        virtual std::string write(ritobin::Bin const& bin, std::vector<char>& data) const = 0;
+        virtual std::string read(ritobin::Bin& bin, std::span<char const> data, size_t jobs = 1) const = 0;
+        virtual std::string write(ritobin::Bin const& bin, std::vector<char>& data, size_t jobs = 1) const = 0;
         virtual bool try_guess(std::string_view data, std::string_view name) const noexcept = 0;
 
         static std::span<DynamicFormat const* const> list() noexcept;
@@ -28,10 +28,14 @@ namespace ritobin::io {
         static DynamicFormat const* guess(std::span<char const> data, std::string_view file_name) noexcept;
     };
 
-    // Read .bin files
-    extern std::string read_binary(Bin& value, std::span<char const> data, BinCompat const* compat) noexcept;
-    // Write .bin files
-    extern std::string write_binary(Bin const& value, std::vector<char>& out, BinCompat const* compat) noexcept;
+    // Read .bin files, entries are decoded on up to jobs threads
+    extern std::string read_binary(Bin& value, std::span<char const> data, BinCompat const* compat, size_t jobs = 1) noexcept;
+    // Read single value of known type from .bin payload
+    extern std::string read_binary(Value& value, Type type, std::span<char const> data, BinCompat const* compat) noexcept;
+    // Write .bin files, entries are serialized on up to jobs threads
+    extern std::string write_binary(Bin const& value, std::vector<char>& out, BinCompat const* compat, size_t jobs = 1) noexcept;
+    // Compute exact size of .bin file
+    extern std::string write_binary_size(Bin const& value, size_t& size, BinCompat const* compat) noexcept;
 
     // Read .txt file
     extern std::string read_text(Bin& value, std::span<char const> data) noexcept;
@@ -1,5 +1,6 @@
 #include "bin_io.hpp"
 #include "bin_types_helper.hpp"
+#include "bin_parallel.hpp"
 
 #define bin_assert(...) do { \
     if (auto start = reader.cur_; !(__VA_ARGS__)) { \
@@ -17,6 +18,10 @@ namespace ritobin::io::impl_binary_read {
             return cur_ - beg_;
         }
 
+        inline constexpr size_t left() const noexcept {
+            return cap_ - cur_;
+        }
+
         template<typename T>
         inline bool read(T& value) noexcept {
             static_assert(std::is_arithmetic_v<T>);
@@ -51,7 +56,8 @@ namespace ritobin::io::impl_binary_read {
             return true;
         }
 
-        bool read(std::string& value) noexcept {
+        template<typename A>
+        bool read(std::basic_string<char, std::char_traits<char>, A>& value) noexcept {
             uint16_t size = {};
             if (!read(size)) {
                 return false;
@@ -59,7 +65,7 @@ namespace ritobin::io::impl_binary_read {
             if (cur_ + size > cap_) {
                 return false;
             }
-            value = { cur_, size };
+            value.assign(cur_, size);
             cur_ += size;
             return true;
         }
@@ -92,13 +98,19 @@ namespace ritobin::io::impl_binary_read {
     };
 
     struct BinBinaryReader {
-        Bin& bin;
         BinaryReader reader;
         std::vector<std::pair<std::string, char const*>> error;
+        size_t jobs = 1;
 
-        bool process() noexcept {
+        bool process_bin(Bin& bin) noexcept {
             bin.sections.clear();
-            bin_assert(read_sections());
+            bin_assert(read_sections(bin));
+            return true;
+        }
+
+        bool process_value(Value& value, Type type) noexcept {
+            bin_assert(read_value_of(value, type));
+            bin_assert(reader.cur_ == reader.cap_);
             return true;
         }
 
@@ -108,7 +120,55 @@ namespace ritobin::io::impl_binary_read {
             return false;
         }
 
-        bool read_sections() noexcept {
+        // Fewest bytes a value of type takes on wire
+        static constexpr size_t min_size(Type type) noexcept {
+            switch (type) {
+            case Type::I16:
+            case Type::U16:
+            case Type::STRING:
+            case Type::OPTION:
+                return 2;
+            case Type::I32:
+            case Type::U32:
+            case Type::F32:
+            case Type::RGBA:
+            case Type::HASH:
+            case Type::LINK:
+            case Type::POINTER:
+                return 4;
+            case Type::I64:
+            case Type::U64:
+            case Type::VEC2:
+            case Type::FILE:
+                return 8;
+            case Type::LIST:
+            case Type::LIST2:
+                return 9;
+            case Type::EMBED:
+            case Type::MAP:
+                return 10;
+            case Type::VEC3:
+                return 12;
+            case Type::VEC4:
+                return 16;
+            case Type::MTX44:
+                return 64;
+            default:
+                return 1;
+            }
+        }
+
+        // Field is name hash, type and value
+        static constexpr size_t min_field_size = 4 + 1 + 1;
+
+        // Reserves for count items of at least item_size bytes each, capped by bytes left so bogus counts can not
+        // make huge allocations
+        template<typename T>
+        void reserve(T& items, size_t count, size_t item_size) noexcept {
+            items.reserve(items.size() + std::min(count, reader.left() / item_size));
+        }
+
+        bool read_sections(Bin& bin) noexcept {
             std::array<char, 4> magic = {};
             uint32_t version = 0;
             bin_assert(reader.read(magic));
@@ -127,46 +187,94 @@ namespace ritobin::io::impl_binary_read {
             bin.sections.emplace("version", U32{ version });
 
             if (version >= 2) {
-                bin_assert(read_linked());
+                bin_assert(read_linked(bin));
             }
-            bin_assert(read_entries());
+            bin_assert(read_entries(bin));
             if (is_patch /*&& version >= 3*/) {
-                bin_assert(read_patches());
+                bin_assert(read_patches(bin));
             }
 
             bin_assert(reader.cur_ == reader.cap_);
             return true;
         }
 
-        bool read_linked() noexcept {
+        bool read_linked(Bin& bin) noexcept {
             List linkedList = { Type::STRING, {} };
             uint32_t linkedFilesCount = {};
             bin_assert(reader.read(linkedFilesCount));
+            reserve(linkedList.items, linkedFilesCount, min_size(Type::STRING));
             for (uint32_t i = 0; i != linkedFilesCount; i++) {
                 String linked = {};
                 bin_assert(reader.read(linked.value));
-                linkedList.items.emplace_back(Element{ linked });
+                linkedList.items.emplace_back(std::move(linked));
             }
             bin.sections.emplace("linked", std::move(linkedList));
             return true;
         }
 
-        bool read_entries() noexcept {
+        bool read_entries(Bin& bin) noexcept {
             uint32_t entryCount = 0;
             std::vector<uint32_t> entryNameHashes;
             bin_assert(reader.read(entryCount));
             bin_assert(reader.read(entryNameHashes, entryCount));
             Map entriesMap = { Type::HASH,  Type::EMBED, {} };
-            for (uint32_t entryNameHash : entryNameHashes) {
-                Hash entryKeyHash = {};
-                Embed entry = { { entryNameHash }, {} };
-                bin_assert(read_entry(entryKeyHash, entry));
-                entriesMap.items.emplace_back(Pair{ std::move(entryKeyHash), std::move(entry) });
+            if (jobs > 1 && entryCount > 1) {
+                if (!read_entries_parallel(entriesMap.items, entryNameHashes)) {
+                    return false;
+                }
+            } else {
+                // Entry is length, key hash and field count
+                reserve(entriesMap.items, entryCount, 4 + 4 + 2);
+                for (uint32_t entryNameHash : entryNameHashes) {
+                    Hash entryKeyHash = {};
+                    Embed entry = { { entryNameHash }, {} };
+                    bin_assert(read_entry(entryKeyHash, entry));
+                    entriesMap.items.emplace_back(Pair{ std::move(entryKeyHash), std::move(entry) });
+                }
             }
             bin.sections.emplace("entries", std::move(entriesMap));
             return true;
         }
 
+        // Entries are length prefixed so they can be located up front and decoded independently.
+        // On failure the lowest failing entry is reported, same as serial decoding would.
+        bool read_entries_parallel(PairList& items, std::vector<uint32_t> const& entryNameHashes) noexcept {
+            auto const count = entryNameHashes.size();
+            std::vector<char const*> offsets;
+            offsets.reserve(count);
+            for (size_t i = 0; i != count; i++) {
+                uint32_t entryLength = 0;
+                offsets.push_back(reader.cur_);
+                bin_assert(reader.read(entryLength));
+                bin_assert(reader.cur_ + entryLength <= reader.cap_);
+                reader.cur_ += entryLength;
+            }
+            items.resize(count);
+
+            auto read_one = [&](BinBinaryReader& entry_reader, size_t i) noexcept {
+                entry_reader.reader.cur_ = offsets[i];
+                Hash entryKeyHash = {};
+                Embed entry = { { entryNameHashes[i] }, {} };
+                if (!entry_reader.read_entry(entryKeyHash, entry)) {
+                    return false;
+                }
+                items[i] = Pair{ std::move(entryKeyHash), std::move(entry) };
+                return true;
+            };
+            auto const failed = parallel_for(count, jobs, [&](size_t i) noexcept {
+                BinBinaryReader entry_reader = { reader, {} };
+                return read_one(entry_reader, i);
+            });
+            if (failed != count) {
+                // decode failing entry again to get its error trace
+                BinBinaryReader entry_reader = { reader, {} };
+                read_one(entry_reader, failed);
+                error.insert(error.end(), entry_reader.error.begin(), entry_reader.error.end());
+                return fail_msg("read_entry(entryKeyHash, entry)", offsets[failed]);
+            }
+            return true;
+        }
+
         bool read_entry(Hash& entryKeyHash, Embed& entry) noexcept {
             uint32_t entryLength = 0;
             uint16_t count = 0;
@@ -174,6 +282,7 @@ namespace ritobin::io::impl_binary_read {
             size_t position = reader.position();
             bin_assert(reader.read(entryKeyHash.value));
             bin_assert(reader.read(count));
+            reserve(entry.items, count, min_field_size);
             for (size_t i = 0; i != count; i++) {
                 auto& [name, item] = entry.items.emplace_back();
                 Type type = {};
@@ -185,10 +294,12 @@ namespace ritobin::io::impl_binary_read {
             return true;
         }
 
-        bool read_patches() noexcept {
+        bool read_patches(Bin& bin) noexcept {
             uint32_t patchCount = {};
             bin_assert(reader.read(patchCount));
             Map patchMap = { Type::HASH,  Type::EMBED, {} };
+            // Patch is key hash, length, type and path
+            reserve(patchMap.items, patchCount, 4 + 4 + 1 + 2);
             for (size_t i = {}; i != patchCount; i++) {
                 Hash entryKeyHash = {};
                 Embed entry = { { "patch" }, {} };
@@ -235,6 +346,7 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(size));
             size_t position = reader.position();
             bin_assert(reader.read(count));
+            reserve(value.items, count, min_field_size);
             for (size_t i = 0; i != count; i++) {
                 auto& [name, item] = value.items.emplace_back();
                 Type type;
@@ -256,6 +368,7 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(size));
             size_t position = reader.position();
             bin_assert(reader.read(count));
+            reserve(value.items, count, min_field_size);
             for (size_t i = 0; i != count; i++) {
                 auto& [name, item] = value.items.emplace_back();
                 Type type = {};
@@ -287,10 +400,7 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(size));
             size_t position = reader.position();
             bin_assert(reader.read(count));
-            for (size_t i = 0; i != count; i++) {
-                auto& [item] = value.items.emplace_back();
-                bin_assert(read_value_of(item, value.valueType));
-            }
+            bin_assert(read_items(value.items, value.valueType, count));
             bin_assert(reader.position() == position + size);
             return true;
         }
@@ -303,10 +413,7 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(size));
             size_t position = reader.position();
             bin_assert(reader.read(count));
-            for (size_t i = 0; i != count; i++) {
-                auto& [item] = value.items.emplace_back();
-                bin_assert(read_value_of(item, value.valueType));
-            }
+            bin_assert(read_items(value.items, value.valueType, count));
             bin_assert(reader.position() == position + size);
             return true;
         }
@@ -321,6 +428,7 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(size));
             size_t position = reader.position();
             bin_assert(reader.read(count));
+            reserve(value.items, count, min_size(value.keyType) + min_size(value.valueType));
             for (size_t i = 0; i != count; i++) {
                 auto& [key, item] = value.items.emplace_back();
                 bin_assert(read_value_of(key, value.keyType));
@@ -335,6 +443,45 @@ namespace ritobin::io::impl_binary_read {
             bin_assert(reader.read(value.value));
             return true;
         }
+
+        // Item type is resolved once per list instead of per item
+        bool read_items(ElementList& items, Type type, uint32_t count) noexcept {
+            return std::visit([this, &items, count](auto&& prototype) noexcept {
+                using value_t = std::remove_cvref_t<decltype(prototype)>;
+                return read_items_of<value_t>(items, count);
+            }, ValueHelper::type_to_value(type));
+        }
+
+        template<typename T>
+        bool read_items_of(ElementList& items, uint32_t count) noexcept {
+            if constexpr (T::category == Category::NUMBER || T::category == Category::VECTOR) {
+                // Fixed size items, whole run is bounds checked up front
+                constexpr auto item_size = sizeof(T::value);
+                bin_assert(reader.left() / item_size >= count);
+                if (items.empty()) {
+                    // Items stay packed, same layout as on disk
+                    auto const values = items.assign_packed<T>(count);
+                    memcpy(values.data(), reader.cur_, item_size * count);
+                    reader.cur_ += item_size * count;
+                    return true;
+                }
+                items.reserve(items.size() + count);
+                for (uint32_t i = 0; i != count; i++) {
+                    T item = {};
+                    memcpy(&item.value, reader.cur_, item_size);
+                    reader.cur_ += item_size;
+                    items.emplace_back(item);
+                }
+            } else {
+                reserve(items, count, min_size(T::type));
+                for (uint32_t i = 0; i != count; i++) {
+                    T item = {};
+                    bin_assert(read_value_visit(item));
+                    items.emplace_back(std::move(item));
+                }
+            }
+            return true;
+        }
     public:
         std::string trace_error() noexcept {
             std::string trace;
@@ -352,11 +499,21 @@ namespace ritobin::io::impl_binary_read {
 namespace ritobin::io {
     using namespace impl_binary_read;
 
-    std::string read_binary(Bin& value, std::span<char const> data, BinCompat const* compat) noexcept {
+    std::string read_binary(Bin& value, std::span<char const> data, BinCompat const* compat, size_t jobs) noexcept {
+        auto const begin = data.data();
+        auto const end = data.data() + data.size();
+        BinBinaryReader reader = { { begin, begin, end, compat }, {}, jobs };
+        if (!reader.process_bin(value)) {
+            return reader.trace_error();
+        }
+        return {};
+    }
+
+    std::string read_binary(Value& value, Type type, std::span<char const> data, BinCompat const* compat) noexcept {
         auto const begin = data.data();
         auto const end = data.data() + data.size();
-        BinBinaryReader reader = { value, { begin, begin, end, compat }, {} };
-        if (!reader.process()) {
+        BinBinaryReader reader = { { begin, begin, end, compat }, {} };
+        if (!reader.process_value(value, type)) {
             return reader.trace_error();
         }
         return {};
@@ -1,6 +1,7 @@
 #include "bin_io.hpp"
 #include "bin_types_helper.hpp"
 #include "bin_numconv.hpp"
+#include "bin_parallel.hpp"
 
 #define bin_assert(...) do { \
     if(!(__VA_ARGS__)) { \
@@ -9,39 +10,112 @@
 
 
 namespace ritobin::io::impl_binary_write {
+    // Counts bytes only, used to size output buffer up front
+    struct SizeWriter {
+        size_t position_ = {};
+        BinCompat const* const compat_;
+
+        bool write_at(size_t, size_t) noexcept {
+            return true;
+        }
+
+        template<typename T, size_t S>
+        void write(std::array<T, S> const&) noexcept {
+            static_assert(std::is_arithmetic_v<T>);
+            position_ += sizeof(T) * S;
+        }
+
+        void write(std::vector<uint32_t> const&, size_t) noexcept {}
+
+        template<typename T>
+        void write(std::span<T const> values) noexcept {
+            position_ += sizeof(T) * values.size();
+        }
+
+        void skip(size_t size) noexcept {
+            position_ += size;
+        }
+
+        template<typename T>
+        void write(T) noexcept {
+            static_assert(std::is_arithmetic_v<T>);
+            position_ += sizeof(T);
+        }
+
+        void write(bool) noexcept {
+            position_ += sizeof(uint8_t);
+        }
+
+        [[nodiscard]] bool write(Type type) noexcept {
+            uint8_t raw = 0;
+            if (compat_->type_to_raw(type, raw)) {
+                position_ += sizeof(uint8_t);
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        template<typename A>
+        void write(std::basic_string<char, std::char_traits<char>, A> const& value) noexcept {
+            position_ += sizeof(uint16_t) + value.size();
+        }
+
+        void write(FNV1a const&) noexcept {
+            position_ += sizeof(uint32_t);
+        }
+
+        void write(XXH64 const&) noexcept {
+            position_ += sizeof(uint64_t);
+        }
+
+        inline size_t position() const noexcept {
+            return position_;
+        }
+    };
+
+    // Appends to buffer that was reserved from SizeWriter, so it never reallocates or zero fills
     struct BinaryWriter {
-        std::vector<char>& buffer_;
+        std::vector<char>& out_;
         BinCompat const* const compat_;
 
+        void append(void const* data, size_t size) noexcept {
+            auto const bytes = static_cast<char const*>(data);
+            out_.insert(out_.end(), bytes, bytes + size);
+        }
+
         bool write_at(size_t offset, size_t value) noexcept {
             auto const tmp = static_cast<uint32_t>(value);
-            memcpy(buffer_.data() + offset, &tmp, sizeof(uint32_t));
+            memcpy(out_.data() + offset, &tmp, sizeof(uint32_t));
             return true;
         }
 
         template<typename T, size_t S>
         void write(std::array<T, S> const& value) noexcept {
             static_assert(std::is_arithmetic_v<T>);
-            char buffer[sizeof(T) * S];
-            memcpy(buffer, value.data(), sizeof(T) * S);
-            buffer_.insert(buffer_.end(), buffer, buffer + sizeof(T) * S);
+            append(value.data(), sizeof(T) * S);
         }
 
         void write(std::vector<uint32_t> const& value, size_t offset) noexcept {
             auto const size = sizeof(uint32_t) * value.size();
-            memcpy(buffer_.data() + offset, value.data(), size);
+            memcpy(out_.data() + offset, value.data(), size);
+        }
+
+        template<typename T>
+        void write(std::span<T const> values) noexcept {
+            static_assert(std::is_trivially_copyable_v<T>);
+            append(values.data(), sizeof(T) * values.size());
         }
 
+        // Only used for placeholders that are patched later
         void skip(size_t size) noexcept {
-            buffer_.insert(buffer_.end(), size, '\x00');
+            out_.resize(out_.size() + size);
         }
 
         template<typename T>
         void write(T value) noexcept {
             static_assert(std::is_arithmetic_v<T>);
-            char buffer[sizeof(value)];
-            memcpy(buffer, &value, sizeof(value));
-            buffer_.insert(buffer_.end(), buffer, buffer + sizeof(buffer));
+            append(&value, sizeof(value));
         }
 
         void write(bool value) noexcept {
@@ -58,9 +132,10 @@ namespace ritobin::io::impl_binary_write {
             }
         }
 
-        void write(std::string const& value) noexcept {
+        template<typename A>
+        void write(std::basic_string<char, std::char_traits<char>, A> const& value) noexcept {
             write(static_cast<uint16_t>(value.size()));
-            buffer_.insert(buffer_.end(), value.data(), value.data() + value.size());
+            append(value.data(), value.size());
         }
 
         void write(FNV1a const& value) noexcept {
@@ -72,17 +147,20 @@ namespace ritobin::io::impl_binary_write {
         }
 
         inline size_t position() const noexcept {
-            return buffer_.size();
+            return out_.size();
         }
     };
 
+    template<typename Writer>
     struct BinBinaryWriter {
-        BinaryWriter writer;
+        Writer writer;
         std::vector<std::string> error;
+        size_t jobs = 1;
+        // Start of every entry followed by end of last one, recorded by sizing pass when jobs > 1
+        std::vector<size_t> entry_offsets = {};
 
         bool process(Bin const& bin) noexcept {
             error.clear();
-            writer.buffer_.clear();
             bin_assert(write_sections(bin));
             return true;
         }
@@ -160,18 +238,67 @@ namespace ritobin::io::impl_binary_write {
             writer.skip(sizeof(uint32_t) * entries->items.size());
             entryNameHashes.reserve(entries->items.size());
 
+            bool const parallel = jobs > 1 && entries->items.size() > 1;
             for (auto const& [entryKey, entryValue] : entries->items) {
                 auto key = std::get_if<Hash>(&entryKey);
                 auto value = std::get_if<Embed>(&entryValue);
                 bin_assert(key);
                 bin_assert(value);
                 entryNameHashes.push_back(value->name.hash());
+                if constexpr (std::is_same_v<Writer, SizeWriter>) {
+                    if (parallel) {
+                        entry_offsets.push_back(writer.position());
+                    }
+                } else if (parallel) {
+                    continue;
+                }
                 bin_assert(write_entry(*key, *value));
             }
+            if constexpr (std::is_same_v<Writer, SizeWriter>) {
+                if (parallel) {
+                    entry_offsets.push_back(writer.position());
+                }
+            } else if (parallel) {
+                bin_assert(entry_offsets.size() == entries->items.size() + 1);
+                if (!write_entries_parallel(entries->items)) {
+                    return false;
+                }
+            }
             writer.write(entryNameHashes, entryNameHashes_offset);
             return true;
         }
 
+        // Entry sizes are known from sizing pass so runs of entries are written into exactly reserved
+        // chunks independently and appended in order.
+        bool write_entries_parallel(PairList const& items) noexcept {
+            auto const count = items.size();
+            auto const chunk_count = std::min(count, jobs * 4);
+            std::vector<std::vector<char>> chunks(chunk_count);
+            std::vector<std::vector<std::string>> errors(chunk_count);
+            auto const failed = parallel_for(chunk_count, jobs, [&](size_t c) noexcept {
+                auto const beg = count * c / chunk_count;
+                auto const end = count * (c + 1) / chunk_count;
+                chunks[c].reserve(entry_offsets[end] - entry_offsets[beg]);
+                BinBinaryWriter entry_writer = { { chunks[c], writer.compat_ }, {} };
+                for (size_t i = beg; i != end; i++) {
+                    auto const& [entryKey, entryValue] = items[i];
+                    if (!entry_writer.write_entry(std::get<Hash>(entryKey), std::get<Embed>(entryValue))) {
+                        errors[c] = std::move(entry_writer.error);
+                        return false;
+                    }
+                }
+                return true;
+            });
+            if (failed != chunk_count) {
+                error.insert(error.end(), errors[failed].begin(), errors[failed].end());
+                return fail_msg("write_entry(*key, *value)\n");
+            }
+            for (auto const& chunk : chunks) {
+                writer.write(std::span<char const>(chunk));
+            }
+            return true;
+        }
+
         bool write_entry(Hash const& entryKey, Embed const& entryValue) noexcept {
             size_t position = writer.position();
             writer.write(uint32_t{});
@@ -212,8 +339,10 @@ namespace ritobin::io::impl_binary_write {
             writer.write(uint32_t{ patchKey.value.hash() });
             size_t position = writer.position();
             writer.write(uint32_t{});
-            auto const name = patchValue.find_field({"path"});
-            auto const value = patchValue.find_field({"value"});
+            constexpr auto path_key = FNV1a { FNV1a::fnv1a("path") };
+            constexpr auto value_key = FNV1a { FNV1a::fnv1a("value") };
+            auto const name = patchValue.find_field(path_key);
+            auto const value = patchValue.find_field(value_key);
             bin_assert(name);
             bin_assert(value);
             auto const nameType = ValueHelper::value_to_type(name->value);
@@ -263,9 +392,7 @@ namespace ritobin::io::impl_binary_write {
             size_t position = writer.position();
             writer.write(uint32_t{ 0 });
             writer.write(static_cast<uint32_t>(value.items.size()));
-            for (auto const& [item] : value.items) {
-                bin_assert(write_value(item, value.valueType));
-            }
+            bin_assert(write_items(value.items, value.valueType));
             writer.write_at(position, writer.position() - position - 4);
             return true;
         }
@@ -276,9 +403,7 @@ namespace ritobin::io::impl_binary_write {
             size_t position = writer.position();
             writer.write(uint32_t{ 0 });
             writer.write(static_cast<uint32_t>(value.items.size()));
-            for (auto const& [item] : value.items) {
-                bin_assert(write_value(item, value.valueType));
-            }
+            bin_assert(write_items(value.items, value.valueType));
             writer.write_at(position, writer.position() - position - 4);
             return true;
         }
@@ -310,6 +435,23 @@ namespace ritobin::io::impl_binary_write {
             return true;
         }
 
+        // Packed items have same layout as on disk and are copied in one go
+        bool write_items(ElementList const& items, Type type) noexcept {
+            if (items.packed_type() == type && type != Type::NONE) {
+                std::visit([this, &items](auto&& prototype) noexcept {
+                    using value_t = std::remove_cvref_t<decltype(prototype)>;
+                    if constexpr (is_packable<value_t>) {
+                        writer.write(items.packed<value_t>());
+                    }
+                }, ValueHelper::type_to_value(type));
+                return true;
+            }
+            for (auto const& [item] : items) {
+                bin_assert(write_value(item, type));
+            }
+            return true;
+        }
+
         bool write_value_visit(None const&) noexcept {
             return true;
         }
@@ -346,8 +488,23 @@ namespace ritobin::io::impl_binary_write {
 namespace ritobin::io {
     using namespace impl_binary_write;
 
-    std::string write_binary(Bin const& bin, std::vector<char>& out, BinCompat const* compat) noexcept {
-        BinBinaryWriter writer = { { out, compat }, {} };
+    std::string write_binary_size(Bin const& bin, size_t& size, BinCompat const* compat) noexcept {
+        BinBinaryWriter<SizeWriter> sizer = { { 0, compat }, {} };
+        if (!sizer.process(bin)) {
+            return sizer.trace_error();
+        }
+        size = sizer.writer.position();
+        return {};
+    }
+
+    std::string write_binary(Bin const& bin, std::vector<char>& out, BinCompat const* compat, size_t jobs) noexcept {
+        out.clear();
+        BinBinaryWriter<SizeWriter> sizer = { { 0, compat }, {}, jobs };
+        if (!sizer.process(bin)) {
+            return sizer.trace_error();
+        }
+        out.reserve(sizer.writer.position());
+        BinBinaryWriter<BinaryWriter> writer = { { out, compat }, {}, jobs, std::move(sizer.entry_offsets) };
         if (!writer.process(bin)) {
             return writer.trace_error();
         }
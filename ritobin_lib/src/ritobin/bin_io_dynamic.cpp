@@ -73,11 +73,11 @@ namespace ritobin::io::dynamic_format_impl {
         bool output_allways_hashed() const noexcept override {
             return true;
         }
-        std::string read(Bin &bin, std::span<const char> data) const override {
-            return read_binary(bin, data, bin_versions[I]);
+        std::string read(Bin &bin, std::span<const char> data, size_t jobs) const override {
+            return read_binary(bin, data, bin_versions[I], jobs);
         }
-        std::string write(const Bin &bin, std::vector<char> &data) const override {
-            return write_binary(bin, data, bin_versions[I]);
+        std::string write(const Bin &bin, std::vector<char> &data, size_t jobs) const override {
+            return write_binary(bin, data, bin_versions[I], jobs);
         }
         bool try_guess(std::string_view data, std::string_view name) const noexcept override {
             if (data.starts_with("PTCH") || data.starts_with("PROP")) {
@@ -105,10 +105,10 @@ namespace ritobin::io::dynamic_format_impl {
         bool output_allways_hashed() const noexcept override {
             return false;
         }
-        std::string read(Bin &bin, std::span<const char> data) const override {
+        std::string read(Bin &bin, std::span<const char> data, size_t) const override {
             return read_text(bin, data);
         }
-        std::string write(const Bin &bin, std::vector<char> &data) const override {
+        std::string write(const Bin &bin, std::vector<char> &data, size_t) const override {
             return write_text(bin, data, 4);
         }
         bool try_guess(std::string_view data, std::string_view name) const noexcept override {
@@ -135,10 +135,10 @@ namespace ritobin::io::dynamic_format_impl {
         bool output_allways_hashed() const noexcept override {
             return false;
         }
-        std::string read(Bin &bin, std::span<const char> data) const override {
+        std::string read(Bin &bin, std::span<const char> data, size_t) const override {
             return read_json(bin, data);
         }
-        std::string write(const Bin &bin, std::vector<char> &data) const override {
+        std::string write(const Bin &bin, std::vector<char> &data, size_t) const override {
             return write_json(bin, data, 2);
         }
         bool try_guess(std::string_view data, std::string_view name) const noexcept override {
@@ -165,10 +165,10 @@ namespace ritobin::io::dynamic_format_impl {
         bool output_allways_hashed() const noexcept override {
             return false;
         }
-        std::string read(Bin&, std::span<const char> data) const override {
+        std::string read(Bin&, std::span<const char> data, size_t) const override {
             return "Json info files can't be read!";
         }
-        std::string write(const Bin &bin, std::vector<char> &data) const override {
+        std::string write(const Bin &bin, std::vector<char> &data, size_t) const override {
             return write_json_info(bin, data, 2);
         }
         bool try_guess(std::string_view, std::string_view) const noexcept override {
@@ -2,8 +2,10 @@
 #include "bin_types.hpp"
 #include "bin_types_helper.hpp"
 #include "bin_numconv.hpp"
-#define JSON_NOEXCEPTION
-#include <json.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
 #include <optional>
 
 #define bin_json_assert(...) \
@@ -23,8 +25,6 @@
 
 
 namespace ritobin::io::json_impl {
-    using json = nlohmann::json;
-
     struct ErrorStack {
         char const* type = {};
         char const* message = {};
@@ -48,9 +48,765 @@ namespace ritobin::io::json_impl {
     };
     using ErrorStackOption = std::optional<ErrorStack>;
 
-    static void value_to_json_info(Value const& value, json& json) noexcept;
-    static void value_to_json(Value const& value, json& json) noexcept;
-    [[nodiscard]] static ErrorStackOption value_from_json(Value& value, json const& json) noexcept;
+    enum class JsonKind : uint8_t {
+        NUL,
+        BOOLEAN,
+        INTEGER,
+        UNSIGNED,
+        FLOAT,
+        STRING,
+        ARRAY,
+        OBJECT,
+    };
+
+    // Document is validated once into flat list of tokens in document order and read in place.
+    // Object members are stored as key string token followed by value tokens.
+    struct JsonToken {
+        JsonKind kind = {};
+        // string: raw chars contain escape sequences
+        bool escaped = {};
+        // string: count of raw chars, array and object: index of token after last member
+        uint32_t size = {};
+        // string: offset of raw chars, boolean and numbers: value bits
+        uint64_t data = {};
+    };
+
+    static int32_t json_hex4(char const* str) noexcept {
+        int32_t result = 0;
+        for (size_t i = 0; i != 4; ++i) {
+            auto const c = str[i];
+            result <<= 4;
+            if (c >= '0' && c <= '9') {
+                result |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                result |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                result |= c - 'A' + 10;
+            } else {
+                return -1;
+            }
+        }
+        return result;
+    }
+
+    template<typename S>
+    static void json_unescape(S& out, char const* first, char const* last) noexcept {
+        while (first != last) {
+            auto const backslash = std::find(first, last, '\\');
+            out.append(first, backslash);
+            if (backslash == last) {
+                break;
+            }
+            first = backslash + 1;
+            switch (auto const c = *first++) {
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                auto codepoint = static_cast<uint32_t>(json_hex4(first));
+                first += 4;
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                    auto const low = static_cast<uint32_t>(json_hex4(first + 2));
+                    first += 6;
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                if (codepoint < 0x80) {
+                    out.push_back(static_cast<char>(codepoint));
+                } else if (codepoint < 0x800) {
+                    out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                } else if (codepoint < 0x10000) {
+                    out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                } else {
+                    out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+                }
+                break;
+            }
+            default: out.push_back(c); break;
+            }
+        }
+    }
+
+    struct JsonParser {
+        char const* const beg;
+        char const* const end;
+        char const* cur;
+        std::vector<JsonToken>& tokens;
+
+        bool parse() noexcept {
+            if (end - cur >= 3 && memcmp(cur, "\xEF\xBB\xBF", 3) == 0) {
+                cur += 3;
+            }
+            std::vector<uint32_t> open = {};
+            for (;;) {
+                if (!skip_space() || cur == end) {
+                    return false;
+                }
+                if (auto const c = *cur; c == '{' || c == '[') {
+                    ++cur;
+                    open.push_back(static_cast<uint32_t>(tokens.size()));
+                    tokens.push_back({ .kind = c == '{' ? JsonKind::OBJECT : JsonKind::ARRAY });
+                    if (!skip_space()) {
+                        return false;
+                    }
+                    if (cur == end || *cur != (c == '{' ? '}' : ']')) {
+                        if (c == '{' && !key()) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    ++cur;
+                    close(open);
+                } else if (!scalar()) {
+                    return false;
+                }
+                // Value done, close finished containers until next member or end of input
+                for (;;) {
+                    if (!skip_space()) {
+                        return false;
+                    }
+                    if (open.empty()) {
+                        return cur == end;
+                    }
+                    if (cur == end) {
+                        return false;
+                    }
+                    auto const is_object = tokens[open.back()].kind == JsonKind::OBJECT;
+                    if (*cur == ',') {
+                        ++cur;
+                        if (is_object && !key()) {
+                            return false;
+                        }
+                        break;
+                    } else if (*cur == (is_object ? '}' : ']')) {
+                        ++cur;
+                        close(open);
+                    } else {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        void close(std::vector<uint32_t>& open) noexcept {
+            tokens[open.back()].size = static_cast<uint32_t>(tokens.size());
+            open.pop_back();
+        }
+
+        bool skip_space() noexcept {
+            while (cur != end) {
+                switch (*cur) {
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\r':
+                    ++cur;
+                    break;
+                case '/':
+                    if (end - cur < 2) {
+                        return false;
+                    } else if (cur[1] == '/') {
+                        cur += 2;
+                        while (cur != end && *cur != '\n' && *cur != '\r') {
+                            ++cur;
+                        }
+                    } else if (cur[1] == '*') {
+                        auto const comment_end = std::string_view { cur + 2, end }.find("*/");
+                        if (comment_end == std::string_view::npos) {
+                            return false;
+                        }
+                        cur += 2 + comment_end + 2;
+                    } else {
+                        return false;
+                    }
+                    break;
+                default:
+                    return true;
+                }
+            }
+            return true;
+        }
+
+        bool key() noexcept {
+            if (!skip_space() || cur == end || *cur != '"' || !string()) {
+                return false;
+            }
+            if (!skip_space() || cur == end || *cur != ':') {
+                return false;
+            }
+            ++cur;
+            return true;
+        }
+
+        bool literal(std::string_view name) noexcept {
+            if (static_cast<size_t>(end - cur) < name.size() || memcmp(cur, name.data(), name.size()) != 0) {
+                return false;
+            }
+            cur += name.size();
+            return true;
+        }
+
+        bool scalar() noexcept {
+            switch (*cur) {
+            case '"':
+                return string();
+            case 't':
+                tokens.push_back({ .kind = JsonKind::BOOLEAN, .data = 1 });
+                return literal("true");
+            case 'f':
+                tokens.push_back({ .kind = JsonKind::BOOLEAN, .data = 0 });
+                return literal("false");
+            case 'n':
+                tokens.push_back({ .kind = JsonKind::NUL });
+                return literal("null");
+            default:
+                return number();
+            }
+        }
+
+        bool digits() noexcept {
+            auto const first = cur;
+            while (cur != end && *cur >= '0' && *cur <= '9') {
+                ++cur;
+            }
+            return cur != first;
+        }
+
+        bool number() noexcept {
+            auto const first = cur;
+            bool is_float = false;
+            if (*cur == '-') {
+                ++cur;
+            }
+            if (cur != end && *cur == '0') {
+                ++cur;
+            } else if (!digits()) {
+                return false;
+            }
+            if (cur != end && *cur == '.') {
+                ++cur;
+                is_float = true;
+                if (!digits()) {
+                    return false;
+                }
+            }
+            auto exponent_sign = '+';
+            if (cur != end && (*cur == 'e' || *cur == 'E')) {
+                ++cur;
+                is_float = true;
+                if (cur != end && (*cur == '+' || *cur == '-')) {
+                    exponent_sign = *cur++;
+                }
+                if (!digits()) {
+                    return false;
+                }
+            }
+            auto const str = std::string_view { first, cur };
+            if (!is_float) {
+                if (*first == '-') {
+                    if (int64_t num = 0; to_num(str, num)) {
+                        tokens.push_back({ .kind = JsonKind::INTEGER, .data = std::bit_cast<uint64_t>(num) });
+                        return true;
+                    }
+                } else {
+                    if (uint64_t num = 0; to_num(str, num)) {
+                        tokens.push_back({ .kind = JsonKind::UNSIGNED, .data = num });
+                        return true;
+                    }
+                }
+            }
+            // Integers out of 64 bit range are kept as float, float overflow is an error and underflow is zero
+            double num = 0;
+            if (!to_num(str, num)) {
+                if (exponent_sign != '-') {
+                    return false;
+                }
+                num = *first == '-' ? -0.0 : 0.0;
+            } else if (!std::isfinite(num)) {
+                return false;
+            }
+            tokens.push_back({ .kind = JsonKind::FLOAT, .data = std::bit_cast<uint64_t>(num) });
+            return true;
+        }
+
+        bool string() noexcept {
+            auto const first = ++cur;
+            bool escaped = false;
+            for (;;) {
+                if (cur == end) {
+                    return false;
+                }
+                auto const c = static_cast<uint8_t>(*cur);
+                if (c == '"') {
+                    break;
+                } else if (c < 0x20) {
+                    return false;
+                } else if (c == '\\') {
+                    escaped = true;
+                    if (!escape()) {
+                        return false;
+                    }
+                } else if (c < 0x80) {
+                    ++cur;
+                } else if (!utf8()) {
+                    return false;
+                }
+            }
+            tokens.push_back({
+                .kind = JsonKind::STRING,
+                .escaped = escaped,
+                .size = static_cast<uint32_t>(cur - first),
+                .data = static_cast<uint64_t>(first - beg),
+            });
+            ++cur;
+            return true;
+        }
+
+        bool escape() noexcept {
+            if (end - cur < 2) {
+                return false;
+            }
+            switch (cur[1]) {
+            case '"':
+            case '\\':
+            case '/':
+            case 'b':
+            case 'f':
+            case 'n':
+            case 'r':
+            case 't':
+                cur += 2;
+                return true;
+            case 'u':
+                break;
+            default:
+                return false;
+            }
+            if (end - cur < 6) {
+                return false;
+            }
+            auto const codepoint = json_hex4(cur + 2);
+            cur += 6;
+            if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+                return false;
+            } else if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+                if (end - cur < 6 || cur[0] != '\\' || cur[1] != 'u') {
+                    return false;
+                }
+                auto const low = json_hex4(cur + 2);
+                if (low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                cur += 6;
+            }
+            return codepoint >= 0;
+        }
+
+        bool utf8() noexcept {
+            auto const in = [this](size_t i, uint8_t min, uint8_t max) noexcept {
+                auto const c = static_cast<uint8_t>(cur[i]);
+                return c >= min && c <= max;
+            };
+            auto const c = static_cast<uint8_t>(*cur);
+            auto const left = end - cur;
+            size_t count = 0;
+            if (c >= 0xC2 && c <= 0xDF) {
+                count = left >= 2 && in(1, 0x80, 0xBF) ? 2 : 0;
+            } else if (c == 0xE0) {
+                count = left >= 3 && in(1, 0xA0, 0xBF) && in(2, 0x80, 0xBF) ? 3 : 0;
+            } else if (c == 0xED) {
+                count = left >= 3 && in(1, 0x80, 0x9F) && in(2, 0x80, 0xBF) ? 3 : 0;
+            } else if (c >= 0xE1 && c <= 0xEF) {
+                count = left >= 3 && in(1, 0x80, 0xBF) && in(2, 0x80, 0xBF) ? 3 : 0;
+            } else if (c == 0xF0) {
+                count = left >= 4 && in(1, 0x90, 0xBF) && in(2, 0x80, 0xBF) && in(3, 0x80, 0xBF) ? 4 : 0;
+            } else if (c >= 0xF1 && c <= 0xF3) {
+                count = left >= 4 && in(1, 0x80, 0xBF) && in(2, 0x80, 0xBF) && in(3, 0x80, 0xBF) ? 4 : 0;
+            } else if (c == 0xF4) {
+                count = left >= 4 && in(1, 0x80, 0x8F) && in(2, 0x80, 0xBF) && in(3, 0x80, 0xBF) ? 4 : 0;
+            }
+            cur += count;
+            return count != 0;
+        }
+    };
+
+    struct JsonDocument {
+        std::span<char const> data = {};
+        std::vector<JsonToken> tokens = {};
+
+        bool parse(std::span<char const> input) noexcept {
+            data = input;
+            tokens.clear();
+            if (data.size() > UINT32_MAX) {
+                return false;
+            }
+            tokens.reserve(data.size() / 8 + 1);
+            auto parser = JsonParser { data.data(), data.data() + data.size(), data.data(), tokens };
+            return parser.parse();
+        }
+    };
+
+    // Read only view of a token, provides the part of DOM interface used by readers below.
+    struct JsonRef {
+        JsonDocument const* doc = {};
+        JsonToken const* token = {};
+
+        bool is_null() const noexcept { return token->kind == JsonKind::NUL; }
+
+        bool is_boolean() const noexcept { return token->kind == JsonKind::BOOLEAN; }
+
+        bool is_number() const noexcept {
+            return token->kind == JsonKind::INTEGER
+                || token->kind == JsonKind::UNSIGNED
+                || token->kind == JsonKind::FLOAT;
+        }
+
+        bool is_string() const noexcept { return token->kind == JsonKind::STRING; }
+
+        bool is_array() const noexcept { return token->kind == JsonKind::ARRAY; }
+
+        bool is_object() const noexcept { return token->kind == JsonKind::OBJECT; }
+
+        JsonRef next() const noexcept {
+            if (token->kind == JsonKind::ARRAY || token->kind == JsonKind::OBJECT) {
+                return { doc, doc->tokens.data() + token->size };
+            }
+            return { doc, token + 1 };
+        }
+
+        bool operator==(JsonRef const& other) const noexcept { return token == other.token; }
+
+        struct Iterator {
+            JsonDocument const* doc;
+            JsonToken const* token;
+
+            JsonRef operator*() const noexcept { return { doc, token }; }
+
+            Iterator& operator++() noexcept {
+                token = JsonRef { doc, token }.next().token;
+                return *this;
+            }
+
+            bool operator==(Iterator const& other) const noexcept = default;
+        };
+
+        // Array elements
+        Iterator begin() const noexcept { return { doc, token + 1 }; }
+
+        Iterator end() const noexcept { return { doc, doc->tokens.data() + token->size }; }
+
+        bool empty() const noexcept { return token + 1 == doc->tokens.data() + token->size; }
+
+        size_t size() const noexcept {
+            size_t result = 0;
+            for (auto i = begin(); i != end(); ++i) {
+                ++result;
+            }
+            return result;
+        }
+
+        JsonRef front() const noexcept { return { doc, token + 1 }; }
+
+        std::string_view raw_string() const noexcept {
+            return { doc->data.data() + token->data, token->size };
+        }
+
+        template<typename S = std::string>
+        S get_string() const noexcept {
+            S result = {};
+            if (token->escaped) {
+                auto const raw = raw_string();
+                json_unescape(result, raw.data(), raw.data() + raw.size());
+            } else {
+                result = raw_string();
+            }
+            return result;
+        }
+
+        bool key_equals(std::string_view key) const noexcept {
+            return token->escaped ? get_string() == key : raw_string() == key;
+        }
+
+        template<typename T>
+        T get() const noexcept {
+            switch (token->kind) {
+            case JsonKind::BOOLEAN:
+                return static_cast<T>(token->data != 0);
+            case JsonKind::INTEGER:
+                return static_cast<T>(std::bit_cast<int64_t>(token->data));
+            case JsonKind::UNSIGNED:
+                return static_cast<T>(token->data);
+            case JsonKind::FLOAT:
+                return static_cast<T>(std::bit_cast<double>(token->data));
+            default:
+                return T{};
+            }
+        }
+
+        // Object member by key, last one wins when key is repeated
+        JsonRef find(std::string_view key) const noexcept {
+            JsonRef result = {};
+            auto const last = doc->tokens.data() + token->size;
+            for (auto member = JsonRef { doc, token + 1 }; member.token != last; member = member.front().next()) {
+                if (member.key_equals(key)) {
+                    result = member.front();
+                }
+            }
+            return result;
+        }
+
+        bool contains(std::string_view key) const noexcept { return find(key).token != nullptr; }
+
+        JsonRef operator[](std::string_view key) const noexcept {
+            static constexpr JsonToken null_token = {};
+            auto result = find(key);
+            return result.token ? result : JsonRef { doc, &null_token };
+        }
+
+        // Object members sorted by key with last duplicate winning, the order DOM objects iterate in
+        std::vector<std::pair<std::string, JsonRef>> items() const noexcept {
+            std::vector<std::pair<std::string, JsonRef>> result = {};
+            auto const last = doc->tokens.data() + token->size;
+            for (auto member = JsonRef { doc, token + 1 }; member.token != last; member = member.front().next()) {
+                result.emplace_back(member.get_string(), member.front());
+            }
+            std::stable_sort(result.begin(), result.end(), [](auto const& lhs, auto const& rhs) {
+                return lhs.first < rhs.first;
+            });
+            auto const duplicate = [](auto const& lhs, auto const& rhs) { return lhs.first == rhs.first; };
+            std::reverse(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end(), duplicate), result.end());
+            std::reverse(result.begin(), result.end());
+            return result;
+        }
+    };
+
+    // Emits straight into output using same layout as DOM dump: objects, arrays and members
+    // go on their own lines when indent >= 0, otherwise everything is on one line without spaces.
+    struct JsonWriter {
+        std::vector<char>& out;
+        int indent = -1;
+        size_t depth = 0;
+        bool first = true;
+        bool after_key = false;
+
+        void raw(std::string_view str) noexcept {
+            out.insert(out.end(), str.begin(), str.end());
+        }
+
+        void newline() noexcept {
+            if (indent >= 0) {
+                out.push_back('\n');
+                out.insert(out.end(), depth * static_cast<size_t>(indent), ' ');
+            }
+        }
+
+        void separator() noexcept {
+            if (!first) {
+                out.push_back(',');
+            }
+            first = false;
+            newline();
+        }
+
+        void element() noexcept {
+            if (after_key) {
+                after_key = false;
+            } else if (depth != 0) {
+                separator();
+            }
+        }
+
+        void begin(char c) noexcept {
+            element();
+            out.push_back(c);
+            ++depth;
+            first = true;
+        }
+
+        void end(char c) noexcept {
+            --depth;
+            if (!first) {
+                newline();
+            }
+            out.push_back(c);
+            first = false;
+        }
+
+        void begin_object() noexcept { begin('{'); }
+
+        void end_object() noexcept { end('}'); }
+
+        void begin_array() noexcept { begin('['); }
+
+        void end_array() noexcept { end(']'); }
+
+        void key(std::string_view name) noexcept {
+            separator();
+            quoted(name);
+            out.push_back(':');
+            if (indent >= 0) {
+                out.push_back(' ');
+            }
+            after_key = true;
+        }
+
+        void null() noexcept {
+            element();
+            raw("null");
+        }
+
+        void string(std::string_view str) noexcept {
+            element();
+            quoted(str);
+        }
+
+        template<typename T>
+        void number(T const& num) noexcept {
+            element();
+            if constexpr (std::is_same_v<T, bool>) {
+                raw(num ? "true" : "false");
+            } else if constexpr (std::is_floating_point_v<T>) {
+                floating(static_cast<double>(num));
+            } else {
+                char buffer[FROM_NUM_MAX];
+                raw({ buffer, from_num(buffer, buffer + sizeof(buffer), num) });
+            }
+        }
+
+        void quoted(std::string_view str) noexcept {
+            static constexpr char hex[] = "0123456789abcdef";
+            out.push_back('"');
+            auto first = str.data();
+            auto const last = str.data() + str.size();
+            for (auto i = first; i != last; ++i) {
+                auto const c = static_cast<uint8_t>(*i);
+                if (c >= 0x20 && c != '"' && c != '\\') {
+                    continue;
+                }
+                out.insert(out.end(), first, i);
+                first = i + 1;
+                switch (c) {
+                case '"': raw("\\\""); break;
+                case '\\': raw("\\\\"); break;
+                case '\b': raw("\\b"); break;
+                case '\f': raw("\\f"); break;
+                case '\n': raw("\\n"); break;
+                case '\r': raw("\\r"); break;
+                case '\t': raw("\\t"); break;
+                default:
+                    raw("\\u00");
+                    out.push_back(hex[c >> 4]);
+                    out.push_back(hex[c & 0xF]);
+                    break;
+                }
+            }
+            out.insert(out.end(), first, last);
+            out.push_back('"');
+        }
+
+        // Shortest round trip digits laid out with fixed notation for exponents in (-4, 15]
+        void floating(double num) noexcept {
+            if (!std::isfinite(num)) {
+                raw("null");
+                return;
+            }
+            if (std::signbit(num)) {
+                out.push_back('-');
+                num = -num;
+            }
+            if (num == 0) {
+                raw("0.0");
+                return;
+            }
+            char buffer[FROM_NUM_MAX];
+            auto const buffer_end = from_num(buffer, buffer + sizeof(buffer), num);
+            // Split into significant digits d1d2...dk and position of decimal point n, num = 0.d1d2...dk * 10^n
+            char digits[FROM_NUM_MAX];
+            int k = 0;
+            int n = 0;
+            bool fraction = false;
+            auto i = buffer;
+            for (; i != buffer_end && *i != 'e'; ++i) {
+                if (*i == '.') {
+                    fraction = true;
+                } else if (k == 0 && *i == '0') {
+                    n -= fraction;
+                } else {
+                    digits[k++] = *i;
+                    n += !fraction;
+                }
+            }
+            if (i != buffer_end) {
+                ++i;
+                i += *i == '+';
+                int exponent = 0;
+                to_num({ i, buffer_end }, exponent);
+                n += exponent;
+            }
+            while (k > 1 && digits[k - 1] == '0') {
+                --k;
+            }
+            if (k <= n && n <= 15) {
+                out.insert(out.end(), digits, digits + k);
+                out.insert(out.end(), static_cast<size_t>(n - k), '0');
+                raw(".0");
+            } else if (0 < n && n <= 15) {
+                out.insert(out.end(), digits, digits + n);
+                out.push_back('.');
+                out.insert(out.end(), digits + n, digits + k);
+            } else if (-4 < n && n <= 0) {
+                raw("0.");
+                out.insert(out.end(), static_cast<size_t>(-n), '0');
+                out.insert(out.end(), digits, digits + k);
+            } else {
+                out.push_back(digits[0]);
+                if (k > 1) {
+                    out.push_back('.');
+                    out.insert(out.end(), digits + 1, digits + k);
+                }
+                out.push_back('e');
+                auto exponent = n - 1;
+                out.push_back(exponent < 0 ? '-' : '+');
+                exponent = exponent < 0 ? -exponent : exponent;
+                if (exponent < 10) {
+                    out.push_back('0');
+                }
+                char exponent_buffer[FROM_NUM_MAX];
+                raw({ exponent_buffer, from_num(exponent_buffer, exponent_buffer + sizeof(exponent_buffer), exponent) });
+            }
+        }
+    };
+
+    using JsonMembers = std::vector<std::pair<std::string, Value const*>>;
+
+    // Writes members sorted by key with last duplicate winning, the order DOM objects are dumped in
+    template<typename F>
+    static void write_members(JsonWriter& json, JsonMembers& members, F&& write_value) noexcept {
+        std::stable_sort(members.begin(), members.end(), [](auto const& lhs, auto const& rhs) {
+            return lhs.first < rhs.first;
+        });
+        json.begin_object();
+        for (size_t i = 0; i != members.size(); ++i) {
+            if (i + 1 != members.size() && members[i + 1].first == members[i].first) {
+                continue;
+            }
+            json.key(members[i].first);
+            write_value(members[i].second);
+        }
+        json.end_object();
+    }
+
+    static void value_to_json_info(Value const& value, JsonWriter& json) noexcept;
+    static void value_to_json(Value const& value, JsonWriter& json) noexcept;
+    [[nodiscard]] static ErrorStackOption value_from_json(Value& value, JsonRef json) noexcept;
 
     static std::string to_index(std::string name) noexcept {
         return "['" + name +"']";
@@ -61,48 +817,46 @@ namespace ritobin::io::json_impl {
     }
 
     template<typename T>
-    static void hash_to_json(T const& value, json& json) noexcept {
+    static void hash_to_json(T const& value, JsonWriter& json) noexcept {
         if (value.str().empty()) {
-            json = value.hash();
+            json.number(value.hash());
         } else {
-            json = value.str();
+            json.string(value.str());
         }
     }
 
     template<typename T>
-    static void hash_to_json_info(T const& value, json& json) noexcept {
+    static std::string hash_to_json_info(T const& value) noexcept {
         if (value.str().empty()) {
-            std::string str;
-            from_num(str, value.hash(), 16);
-            json = "0x" + str;
+            char str[FROM_NUM_MAX] = { '0', 'x' };
+            auto const end = from_num(str + 2, str + sizeof(str), value.hash(), 16);
+            return std::string { str, end ? end : str + 2 };
         } else {
-            json = value.str();
+            return std::string { value.str() };
         }
     }
 
     template<typename T>
-    static bool hash_from_json(T& value, json const& json) noexcept {
+    static bool hash_from_json(T& value, JsonRef json) noexcept {
         using hash_t = std::remove_cvref_t<decltype(value.hash())>;
         if (json.is_number()) {
-            hash_t hash = json;
-            value = hash;
+            value = json.get<hash_t>();
             return true;
         } else if (json.is_string()){
-            std::string str = json;
-            value = str;
+            value = json.get_string();
             return true;
         } else {
             return false;
         }
     }
 
-    static ErrorStackOption item_from_json(Element& value, json const& json) noexcept {
+    static ErrorStackOption item_from_json(Element& value, JsonRef json) noexcept {
         static constexpr char const * type_name = "element";
         bin_json_rethrow("", value_from_json(value.value, json));
         return std::nullopt;
     }
 
-    static ErrorStackOption item_from_json(Pair& value, json const& json) noexcept {
+    static ErrorStackOption item_from_json(Pair& value, JsonRef json) noexcept {
         static constexpr char const * type_name = "pair";
         bin_json_assert(json.is_object());
         bin_json_assert(json.contains("key"));
@@ -112,21 +866,21 @@ namespace ritobin::io::json_impl {
         return std::nullopt;
     }
 
-    static ErrorStackOption typed_from_json(Value& value, json const& json) noexcept {
+    static ErrorStackOption typed_from_json(Value& value, JsonRef json) noexcept {
         static constexpr char const * type_name = "value";
         bin_json_assert(json.is_object());
         bin_json_assert(json.contains("type"));
         bin_json_assert(json.contains("value"));
         bin_json_assert(json["type"].is_string());
         Type type = Type::NONE;
-        std::string valueType_name = json["type"];
+        std::string valueType_name = json["type"].get_string();
         bin_json_assert(ValueHelper::try_type_name_to_type(valueType_name, type));
         value = ValueHelper::type_to_value(type);
         bin_json_rethrow(to_index("value"), value_from_json(value, json["value"]));
         return std::nullopt;
     }
 
-    static ErrorStackOption item_from_json(Field& value, json const& json) noexcept {
+    static ErrorStackOption item_from_json(Field& value, JsonRef json) noexcept {
         static constexpr char const * type_name = "field";
         bin_json_assert(json.is_object());
         bin_json_assert(json.contains("key"));
@@ -142,15 +896,15 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::NONE> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const&, json& json) noexcept {
-            json = nullptr;
+        static void to_json(T const&, JsonWriter& json) noexcept {
+            json.null();
         }
 
-        static void to_json_info(T const&, json& json) noexcept {
-            json = nullptr;
+        static void to_json_info(T const&, JsonWriter& json) noexcept {
+            json.null();
         }
 
-        static ErrorStackOption from_json(T&, json const& json) noexcept {
+        static ErrorStackOption from_json(T&, JsonRef json) noexcept {
             bin_json_assert(json.is_null());
             return std::nullopt;
         }
@@ -160,22 +914,22 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::NUMBER> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.number(value.value);
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            json.number(value.value);
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             using value_t = std::remove_cvref_t<decltype(value.value)>;
             if constexpr (std::is_same_v<value_t, bool>) {
                 bin_json_assert(json.is_boolean());
             } else {
                 bin_json_assert(json.is_number());
             }
-            value.value = json;
+            value.value = json.get<value_t>();
             return std::nullopt;
         }
     };
@@ -184,20 +938,26 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::VECTOR> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.begin_array();
+            for (auto const& item: value.value) {
+                json.number(item);
+            }
+            json.end_array();
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            to_json(value, json);
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
+            using item_t = std::remove_cvref_t<decltype(value.value[0])>;
             bin_json_assert(json.is_array());
             bin_json_assert(json.size() <= value.value.size());
             size_t i = 0;
             for (auto const& item: json) {
-                value.value[i++] = item;
+                bin_json_assert(item.is_number() || item.is_boolean());
+                value.value[i++] = item.get<item_t>();
             }
             return std::nullopt;
         }
@@ -207,17 +967,17 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::STRING> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.string(value.value);
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = value.value;
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            json.string(value.value);
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(json.is_string());
-            value.value = json;
+            value.value = json.get_string<BinString>();
             return std::nullopt;
         }
     };
@@ -226,15 +986,15 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::HASH> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
+        static void to_json(T const& value, JsonWriter& json) noexcept {
             hash_to_json(value.value, json);
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            hash_to_json_info(value.value, json);
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            json.string(hash_to_json_info(value.value));
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(hash_from_json(value.value, json));
             return std::nullopt;
         }
@@ -244,33 +1004,36 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::OPTION> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = json::object();
-            json["valueType"] =  ValueHelper::type_to_type_name(value.valueType);
-            auto& json_items = json["items"];
-            json_items = json::array();
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.begin_object();
+            json.key("items");
+            json.begin_array();
             if (!value.items.empty()) {
-                value_to_json(value.items.front().value, json_items.emplace_back());
+                value_to_json(value.items.begin()->value, json);
             }
+            json.end_array();
+            json.key("valueType");
+            json.string(ValueHelper::type_to_type_name(value.valueType));
+            json.end_object();
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
             if (value.items.empty()) {
-                json = nullptr;
+                json.null();
             } else {
-                value_to_json(value.items.front().value, json);
+                value_to_json(value.items.begin()->value, json);
             }
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(json.is_object());
             bin_json_assert(json.contains("valueType"));
             bin_json_assert(json.contains("items"));
             bin_json_assert(json["valueType"].is_string());
             bin_json_assert(json["items"].is_array());
-            std::string valueType_name = json["valueType"];
+            std::string valueType_name = json["valueType"].get_string();
             bin_json_assert(ValueHelper::try_type_name_to_type(valueType_name, value.valueType));
-            auto const& json_items = json["items"];
+            auto const json_items = json["items"];
             if (!json_items.empty()) {
                 auto& value_item = value.items.emplace_back(ValueHelper::type_to_value(value.valueType));
                 bin_json_rethrow(to_index("items") + to_index(0),
@@ -284,32 +1047,56 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::LIST> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = json::object();
-            json["valueType"] = ValueHelper::type_to_type_name(value.valueType);
-            auto& json_items = json["items"];
-            json_items = json::array();
-            for (auto const& value_item: value.items) {
-                value_to_json(value_item.value, json_items.emplace_back());
-            }
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.begin_object();
+            json.key("items");
+            json.begin_array();
+            items_to_json<false>(value.items, json);
+            json.end_array();
+            json.key("valueType");
+            json.string(ValueHelper::type_to_type_name(value.valueType));
+            json.end_object();
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = json::array();
-            for (auto const& item: value.items) {
-                value_to_json_info(item.value, json.emplace_back());
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            json.begin_array();
+            items_to_json<true>(value.items, json);
+            json.end_array();
+        }
+
+        // Packed items are written straight from their values
+        template<bool info>
+        static void items_to_json(ElementList const& items, JsonWriter& json) noexcept {
+            if (items.packed_type() != Type::NONE) {
+                std::visit([&items, &json](auto&& prototype) noexcept {
+                    using item_t = std::remove_cvref_t<decltype(prototype)>;
+                    if constexpr (is_packable<item_t>) {
+                        for (auto const& item: items.packed<item_t>()) {
+                            json_value_impl<item_t>::to_json(item_t { item }, json);
+                        }
+                    }
+                }, ValueHelper::type_to_value(items.packed_type()));
+                return;
+            }
+            for (auto const& item: items) {
+                if constexpr (info) {
+                    value_to_json_info(item.value, json);
+                } else {
+                    value_to_json(item.value, json);
+                }
             }
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(json.is_object());
             bin_json_assert(json.contains("valueType"));
             bin_json_assert(json.contains("items"));
             bin_json_assert(json["valueType"].is_string());
             bin_json_assert(json["items"].is_array());
-            std::string valueType_name = json["valueType"];
+            std::string valueType_name = json["valueType"].get_string();
             bin_json_assert(ValueHelper::try_type_name_to_type(valueType_name, value.valueType));
-            auto const& json_items = json["items"];
+            auto const json_items = json["items"];
+            value.items.reserve(json_items.size());
             size_t index = 0;
             for (auto const& json_item: json_items) {
                 auto& value_item = value.items.emplace_back(ValueHelper::type_to_value(value.valueType));
@@ -325,36 +1112,48 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::MAP> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = json::object();
-            json["keyType"] = ValueHelper::type_to_type_name(value.keyType);
-            json["valueType"] = ValueHelper::type_to_type_name(value.valueType);
-            auto& json_items = json["items"];
-            json_items = json::array();
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.begin_object();
+            json.key("items");
+            json.begin_array();
             for (auto const& value_item: value.items) {
-                auto& json_item = json_items.emplace_back();
-                json_item = json::object();
-                value_to_json(value_item.key, json_item["key"]);
-                value_to_json(value_item.value, json_item["value"]);
+                json.begin_object();
+                json.key("key");
+                value_to_json(value_item.key, json);
+                json.key("value");
+                value_to_json(value_item.value, json);
+                json.end_object();
             }
+            json.end_array();
+            json.key("keyType");
+            json.string(ValueHelper::type_to_type_name(value.keyType));
+            json.key("valueType");
+            json.string(ValueHelper::type_to_type_name(value.valueType));
+            json.end_object();
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = json::object();
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            JsonMembers members = {};
+            members.reserve(value.items.size());
+            std::vector<char> key_json = {};
             for (auto const& item: value.items) {
-                nlohmann::json key_json = {};
-                value_to_json_info(item.key, key_json);
+                key_json.clear();
+                auto key_writer = JsonWriter { key_json };
+                value_to_json_info(item.key, key_writer);
                 std::string key;
-                if (key_json.is_string()) {
-                    key = key_json;
+                if (!key_json.empty() && key_json.front() == '"') {
+                    json_unescape(key, key_json.data() + 1, key_json.data() + key_json.size() - 1);
                 } else {
-                    key = key_json.dump();
+                    key.assign(key_json.begin(), key_json.end());
                 }
-                value_to_json_info(item.value, json[key]);
+                members.emplace_back(std::move(key), &item.value);
             }
+            write_members(json, members, [&json](Value const* item) noexcept {
+                value_to_json_info(*item, json);
+            });
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(json.is_object());
             bin_json_assert(json.contains("valueType"));
             bin_json_assert(json.contains("keyType"));
@@ -362,11 +1161,12 @@ namespace ritobin::io::json_impl {
             bin_json_assert(json["valueType"].is_string());
             bin_json_assert(json["keyType"].is_string());
             bin_json_assert(json["items"].is_array());
-            std::string keyType_name = json["keyType"];
-            std::string valueType_name = json["valueType"];
+            std::string keyType_name = json["keyType"].get_string();
+            std::string valueType_name = json["valueType"].get_string();
             bin_json_assert(ValueHelper::try_type_name_to_type(keyType_name, value.keyType));
             bin_json_assert(ValueHelper::try_type_name_to_type(valueType_name, value.valueType));
-            auto const& json_items = json["items"];
+            auto const json_items = json["items"];
+            value.items.reserve(json_items.size());
             size_t index = 0;
             for (auto const& json_item: json_items) {
                 auto& value_item = value.items.emplace_back(ValueHelper::type_to_value(value.keyType),
@@ -383,43 +1183,51 @@ namespace ritobin::io::json_impl {
     struct json_value_impl<T, Category::CLASS> {
         static constexpr char const * type_name = T::type_name;
 
-        static void to_json(T const& value, json& json) noexcept {
-            json = json::object();
-            hash_to_json(value.name, json["name"]);
-            auto& json_items = json["items"];
-            json_items = json::array();
+        static void to_json(T const& value, JsonWriter& json) noexcept {
+            json.begin_object();
+            json.key("items");
+            json.begin_array();
             for (auto const& value_item: value.items) {
-                auto& json_item = json_items.emplace_back();
-                json_item = json::object();
-                hash_to_json(value_item.key, json_item["key"]);
-                json_item["type"] = ValueHelper::value_to_type_name(value_item.value);
-                value_to_json(value_item.value, json_item["value"]);
+                json.begin_object();
+                json.key("key");
+                hash_to_json(value_item.key, json);
+                json.key("type");
+                json.string(ValueHelper::value_to_type_name(value_item.value));
+                json.key("value");
+                value_to_json(value_item.value, json);
+                json.end_object();
             }
+            json.end_array();
+            json.key("name");
+            hash_to_json(value.name, json);
+            json.end_object();
         }
 
-        static void to_json_info(T const& value, json& json) noexcept {
-            json = json::object();
-            hash_to_json_info(value.name, json["~class"]);
+        static void to_json_info(T const& value, JsonWriter& json) noexcept {
+            // nullptr stands for class name
+            JsonMembers members = {};
+            members.reserve(value.items.size() + 1);
+            members.emplace_back("~class", nullptr);
             for (auto const& item: value.items) {
-                nlohmann::json key_json = {};
-                hash_to_json_info(item.key, key_json);
-                std::string key;
-                if (key_json.is_string()) {
-                    key = key_json;
+                members.emplace_back(hash_to_json_info(item.key), &item.value);
+            }
+            write_members(json, members, [&json, &value](Value const* item) noexcept {
+                if (item) {
+                    value_to_json_info(*item, json);
                 } else {
-                    key = key_json.dump();
+                    json.string(hash_to_json_info(value.name));
                 }
-                value_to_json_info(item.value, json[key]);
-            }
+            });
         }
 
-        static ErrorStackOption from_json(T& value, json const& json) noexcept {
+        static ErrorStackOption from_json(T& value, JsonRef json) noexcept {
             bin_json_assert(json.is_object());
             bin_json_assert(json.contains("name"));
             bin_json_assert(json.contains("items"));
             bin_json_assert(hash_from_json(value.name, json["name"]));
             bin_json_assert(json["items"].is_array());
-            auto const& json_items = json["items"];
+            auto const json_items = json["items"];
+            value.items.reserve(json_items.size());
             size_t index = 0;
             for (auto const& json_item: json_items) {
                 auto& value_item = value.items.emplace_back();
@@ -431,21 +1239,21 @@ namespace ritobin::io::json_impl {
         }
     };
 
-    void value_to_json(Value const& value, json& json) noexcept {
+    void value_to_json(Value const& value, JsonWriter& json) noexcept {
         std::visit([&json](auto const& value) noexcept {
             using value_t = std::remove_cvref_t<decltype(value)>;
             json_value_impl<value_t>::to_json(value, json);
         }, value);
     }
 
-    void value_to_json_info(Value const& value, json& json) noexcept {
+    void value_to_json_info(Value const& value, JsonWriter& json) noexcept {
         std::visit([&json](auto const& value) noexcept {
             using value_t = std::remove_cvref_t<decltype(value)>;
             json_value_impl<value_t>::to_json_info(value, json);
         }, value);
     }
 
-    ErrorStackOption value_from_json(Value& value, json const& json) noexcept {
+    ErrorStackOption value_from_json(Value& value, JsonRef json) noexcept {
         return std::visit([&json](auto& value) noexcept {
             using value_t = std::remove_cvref_t<decltype(value)>;
             return json_value_impl<value_t>::from_json(value, json);
@@ -453,32 +1261,39 @@ namespace ritobin::io::json_impl {
     }
 
     static void bin_to_json(Bin const& value, std::vector<char>& out, int indent) noexcept {
-        json json = json::object();
+        auto json = JsonWriter { out, indent };
+        JsonMembers members = {};
         for (auto const& section: value.sections) {
-            auto& json_item = json[section.first];
-            json_item = json::object();
-            json_item["type"] = ValueHelper::value_to_type_name(section.second);
-            value_to_json(section.second, json_item["value"]);
+            members.emplace_back(section.first, &section.second);
         }
-        auto tmp = json.dump(indent);
-        out.insert(out.end(), tmp.begin(), tmp.end());
+        write_members(json, members, [&json](Value const* section) noexcept {
+            json.begin_object();
+            json.key("type");
+            json.string(ValueHelper::value_to_type_name(*section));
+            json.key("value");
+            value_to_json(*section, json);
+            json.end_object();
+        });
     }
 
     static void bin_to_json_info(Bin const& value, std::vector<char>& out, int indent) noexcept {
-        json json = json::object();
+        auto json = JsonWriter { out, indent };
+        JsonMembers members = {};
         for (auto const& section: value.sections) {
-            value_to_json_info(section.second, json[section.first]);
+            members.emplace_back(section.first, &section.second);
         }
-        auto tmp = json.dump(indent);
-        out.insert(out.end(), tmp.begin(), tmp.end());
+        write_members(json, members, [&json](Value const* section) noexcept {
+            value_to_json_info(*section, json);
+        });
     }
 
     static ErrorStackOption bin_from_json(Bin& bin, std::span<char const> data) noexcept {
         static constexpr char const * type_name = "bin";
-        json json = json::parse(data, nullptr, false, true);
-        if (json.is_discarded()) {
+        JsonDocument document = {};
+        if (!document.parse(data)) {
             return ErrorStack { "bin", "Bad json", "/" };
         }
+        auto const json = JsonRef { &document, document.tokens.data() };
         bin_json_assert(json.is_object());
         for (auto const& [json_key, json_item]: json.items()) {
             auto& section = bin.sections[json_key];
@@ -9,6 +9,26 @@
     } } while(false)
 
 namespace ritobin::io::impl_text_read {
+    // Character classes shared by every scanning loop, one table lookup per byte instead of compare chains
+    static inline constexpr uint8_t CHAR_SPACE = 1;
+    static inline constexpr uint8_t CHAR_WORD = 2;
+
+    static inline constexpr auto CHAR_CLASSES = [] {
+        std::array<uint8_t, 256> result = {};
+        for (char c: std::string_view { " \t\r" }) {
+            result[static_cast<uint8_t>(c)] |= CHAR_SPACE;
+        }
+        for (char c: std::string_view { "_+-." }) {
+            result[static_cast<uint8_t>(c)] |= CHAR_WORD;
+        }
+        for (int c = 0; c != 256; c++) {
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+                result[c] |= CHAR_WORD;
+            }
+        }
+        return result;
+    }();
+
     struct TextReader {
         char const* const beg_ = nullptr;
         char const* cur_ = nullptr;
@@ -24,6 +44,18 @@ namespace ritobin::io::impl_text_read {
             return c >= F && c <= T;
         }
 
+        template<uint8_t Class>
+        static inline constexpr bool is_class(char c) noexcept {
+            return CHAR_CLASSES[static_cast<uint8_t>(c)] & Class;
+        }
+
+        template<uint8_t Class>
+        constexpr void skip_class() noexcept {
+            while (cur_ != cap_ && is_class<Class>(*cur_)) {
+                cur_++;
+            }
+        }
+
         inline constexpr bool is_eof() const noexcept {
             return cur_ == cap_;
         }
@@ -34,9 +66,7 @@ namespace ritobin::io::impl_text_read {
 
         template<char Symbol>
         constexpr bool read_symbol() noexcept {
-            while (!is_eof() && one_of<' ', '\t', '\r'>(*cur_)) {
-                cur_++;
-            }
+            skip_class<CHAR_SPACE>();
             if (cur_ != cap_ && *cur_ == Symbol) {
                 cur_++;
                 return true;
@@ -45,38 +75,30 @@ namespace ritobin::io::impl_text_read {
         }
 
         constexpr bool next_newline() noexcept {
-            bool comment = false;
             bool newline = false;
-            while (!is_eof()) {
-                if (one_of<' ', '\t', '\r'>(*cur_)) {
-                    cur_++;
-                } else if (*cur_ == '\n') {
-                    comment = false;
-                    newline = true;
-                    cur_++;
-                } else if (*cur_ == '#') {
-                    comment = true;
-                    cur_++;
-                } else if (comment) {
-                    cur_++;
-                } else {
+            for (;;) {
+                skip_class<CHAR_SPACE>();
+                if (is_eof()) {
+                    break;
+                }
+                if (*cur_ == '#') {
+                    auto const end = std::char_traits<char>::find(cur_, static_cast<size_t>(cap_ - cur_), '\n');
+                    cur_ = end ? end : cap_;
+                    continue;
+                }
+                if (*cur_ != '\n') {
                     break;
                 }
+                newline = true;
+                cur_++;
             }
             return newline;
         }
 
         constexpr std::string_view read_word() noexcept {
-            while (!is_eof() && one_of<' ', '\t', '\r'>(*cur_)) {
-                cur_++;
-            }
+            skip_class<CHAR_SPACE>();
             auto const beg = cur_;
-            while (!is_eof() && (one_of<'_', '+', '-', '.'>(*cur_)
-                || in_range<'A', 'Z'>(*cur_)
-                || in_range<'a', 'z'>(*cur_)
-                || in_range<'0', '9'>(*cur_))) {
-                cur_++;
-            }
+            skip_class<CHAR_WORD>();
             return { beg, static_cast<size_t>(cur_ - beg) };
         }
 
@@ -123,11 +145,10 @@ namespace ritobin::io::impl_text_read {
             return false;
         }
 
-        bool read_string(std::string& result) noexcept {
+        template<typename S>
+        bool read_string(S& result) noexcept {
             // FIXME: unicode verification
-            while (!is_eof() && one_of<' ', '\t', '\r'>(*cur_)) {
-                cur_++;
-            }
+            skip_class<CHAR_SPACE>();
             if (cur_ == cap_) {
                 return false;
             }
@@ -208,7 +229,7 @@ namespace ritobin::io::impl_text_read {
             }
             cur_ = backup;
             if (std::string str; read_name(str)) {
-                value = { str };
+                value = str;
                 return true;
             }
             return false;
@@ -221,7 +242,7 @@ namespace ritobin::io::impl_text_read {
             }
             cur_ = backup;
             if (std::string str; read_string(str)) {
-                value = { str };
+                value = str;
                 return true;
             }
             return false;
@@ -234,7 +255,7 @@ namespace ritobin::io::impl_text_read {
             }
             cur_ = backup;
             if (std::string str; read_string(str)) {
-                value = { str };
+                value = str;
                 return true;
             }
             return false;
@@ -2,6 +2,8 @@
 #include "bin_types_helper.hpp"
 #include "bin_numconv.hpp"
 #include "bin_strconv.hpp"
+#include "bin_unhash.hpp"
+#include "bin_view.hpp"
 
 namespace ritobin::io::text_write_impl {
     struct TextWriter {
@@ -37,9 +39,9 @@ namespace ritobin::io::text_write_impl {
         template<typename T>
         void write(T value) noexcept {
             static_assert(std::is_arithmetic_v<T>);
-            std::string result;
-            from_num(result, value);
-            buffer_.insert(buffer_.end(), result.begin(), result.end());
+            char result[FROM_NUM_MAX];
+            auto const end = from_num(result, result + sizeof(result), value);
+            buffer_.insert(buffer_.end(), result, end ? end : result);
         }
 
         template<typename T, size_t SIZE>
@@ -90,7 +92,8 @@ namespace ritobin::io::text_write_impl {
             str_quote(str, buffer_);
         }
 
-        void write(std::string const& str) noexcept {
+        template<typename A>
+        void write(std::basic_string<char, std::char_traits<char>, A> const& str) noexcept {
             write(std::string_view{str.data(), str.size()});
         }
 
@@ -213,6 +216,29 @@ namespace ritobin::io::text_write_impl {
             writer.write_raw("}");
         }
 
+        void write_items(ElementList const& items) noexcept {
+            if (items.packed_type() == Type::NONE || items.empty()) {
+                write_items<ElementList>(items);
+                return;
+            }
+            // Packed items are written straight from their values
+            writer.write_raw("{\n");
+            writer.ident_inc();
+            std::visit([this, &items](auto&& prototype) {
+                using item_t = std::remove_cvref_t<decltype(prototype)>;
+                if constexpr (is_packable<item_t>) {
+                    for (auto const& item : items.packed<item_t>()) {
+                        writer.pad();
+                        write_value_visit(item_t { item });
+                        writer.write_raw("\n");
+                    }
+                }
+            }, ValueHelper::type_to_value(items.packed_type()));
+            writer.ident_dec();
+            writer.pad();
+            writer.write_raw("}");
+        }
+
         void write_type_visit(List const& value) noexcept {
             writer.write(value.type);
             writer.write_raw("[");
@@ -328,9 +354,361 @@ namespace ritobin::io::text_write_impl {
     };
 }
 
+namespace ritobin::io::text_write_impl {
+    // Same output as BinTextWriter over bin read_binary would produce, written while walking the buffer
+    struct ViewTextWriter {
+        TextWriter writer;
+        FILE* out;
+        BinUnhasher const* unhasher;
+        char const* base;
+        std::string error = {};
+        // Items around malformed value, innermost first
+        std::vector<std::pair<std::string, char const*>> trace = {};
+
+        static inline constexpr size_t chunk_size = 64 * 1024;
+
+        bool process_view(BinView const& view) noexcept {
+            writer.buffer_.clear();
+            writer.buffer_.reserve(chunk_size * 2);
+            writer.write_raw("#PROP_text\n");
+            writer.write_raw("type: string = ");
+            writer.write(std::string_view { view.is_patch() ? "PTCH" : "PROP" });
+            writer.write_raw("\nversion: u32 = ");
+            writer.write(view.version());
+            writer.write_raw("\n");
+            if (view.version() >= 2) {
+                writer.write_raw("linked: list[string] = ");
+                if (!write_items(view.linked())) {
+                    return fail_trace("Malformed linked");
+                }
+                writer.write_raw("\n");
+            }
+            writer.write_raw("entries: map[hash,embed] = ");
+            if (!write_entries(view.entries())) {
+                return error.empty() ? fail_trace("Malformed entry") : false;
+            }
+            writer.write_raw("\n");
+            if (view.is_patch()) {
+                writer.write_raw("patches: map[hash,embed] = ");
+                if (!write_patches(view.patches())) {
+                    return error.empty() ? fail_trace("Malformed patch") : false;
+                }
+                writer.write_raw("\n");
+            }
+            return flush(true);
+        }
+    private:
+        bool fail(std::string msg) noexcept {
+            error = std::move(msg);
+            return false;
+        }
+
+        // Message followed by one "item @ offset" line per level, outermost item first
+        bool fail_trace(std::string msg) noexcept {
+            error = std::move(msg);
+            error.append("\n");
+            for (auto e = trace.crbegin(); e != trace.crend(); e++) {
+                error.append(e->first);
+                error.append(" @ ");
+                error.append(std::to_string(e->second - base));
+                error.append("\n");
+            }
+            return false;
+        }
+
+        template<typename T>
+        std::string describe_hash(T hash) const {
+            if (auto const name = find_name(hash); !name.empty()) {
+                return std::string(name);
+            }
+            char buffer[32] = {};
+            if constexpr (sizeof(T) == 4) {
+                snprintf(buffer, sizeof(buffer), "0x%08x", static_cast<unsigned>(hash));
+            } else {
+                snprintf(buffer, sizeof(buffer), "0x%016llx", static_cast<unsigned long long>(hash));
+            }
+            return buffer;
+        }
+
+        std::string describe(ValueView const&, size_t index) const {
+            return "item " + std::to_string(index);
+        }
+
+        std::string describe(FieldView const& item, size_t) const {
+            return "field " + describe_hash(item.key);
+        }
+
+        std::string describe(PairView const&, size_t index) const {
+            return "pair " + std::to_string(index);
+        }
+
+        std::string describe(EntryView const& item, size_t) const {
+            return "entry " + describe_hash(item.key);
+        }
+
+        std::string describe(PatchView const& item, size_t) const {
+            return "patch " + describe_hash(item.key);
+        }
+
+        // Hands buffered text to file once there is enough of it
+        bool flush(bool force) noexcept {
+            if (writer.buffer_.size() < chunk_size && !force) {
+                return true;
+            }
+            auto const size = writer.buffer_.size();
+            if (fwrite(writer.buffer_.data(), 1, size, out) != size) {
+                return fail("Failed to write output");
+            }
+            writer.buffer_.clear();
+            return true;
+        }
+
+        template<typename T>
+        std::string_view find_name(T hash) const noexcept {
+            return unhasher ? unhasher->find_name(hash) : std::string_view{};
+        }
+
+        void write_name(uint32_t hash) noexcept {
+            if (auto const name = find_name(hash); !name.empty()) {
+                writer.write_raw(name);
+            } else {
+                writer.write_hex(hash);
+            }
+        }
+
+        template<typename T>
+        void write_string(T hash) noexcept {
+            if (auto const name = find_name(hash); !name.empty()) {
+                writer.write(name);
+            } else {
+                writer.write_hex(hash);
+            }
+        }
+
+        template<typename C, typename F>
+        bool write_cursor(C cursor, F&& write_item) noexcept {
+            if (cursor.size() == 0) {
+                writer.write_raw("{}");
+                return cursor.ok();
+            }
+            writer.write_raw("{\n");
+            writer.ident_inc();
+            typename std::remove_cvref_t<decltype(cursor)>::item_type item = {};
+            for (size_t index = 0;; index++) {
+                auto const position = cursor.cur_;
+                auto const last = cursor.size() == 0;
+                if (!cursor.next(item)) {
+                    if (!cursor.ok()) {
+                        trace.emplace_back(last ? "unused data after " + std::to_string(index) + " items"
+                                                : "unreadable item " + std::to_string(index),
+                                           position);
+                        return false;
+                    }
+                    break;
+                }
+                writer.pad();
+                if (!write_item(item)) {
+                    if (error.empty()) {
+                        trace.emplace_back(describe(item, index), position);
+                    }
+                    return false;
+                }
+                writer.write_raw("\n");
+                if (!flush(false)) {
+                    return false;
+                }
+            }
+            writer.ident_dec();
+            writer.pad();
+            writer.write_raw("}");
+            return true;
+        }
+
+        bool write_items(ElementCursor cursor) noexcept {
+            return write_cursor(cursor, [this](ValueView const& item) noexcept {
+                return write_value(item);
+            });
+        }
+
+        bool write_fields(FieldCursor cursor) noexcept {
+            return write_cursor(cursor, [this](FieldView const& item) noexcept {
+                write_name(item.key);
+                writer.write_raw(": ");
+                if (!write_type(item.value)) {
+                    return false;
+                }
+                writer.write_raw(" = ");
+                return write_value(item.value);
+            });
+        }
+
+        bool write_pairs(PairCursor cursor) noexcept {
+            return write_cursor(cursor, [this](PairView const& item) noexcept {
+                if (!write_value(item.key)) {
+                    return false;
+                }
+                writer.write_raw(" = ");
+                return write_value(item.value);
+            });
+        }
+
+        bool write_entries(EntryCursor cursor) noexcept {
+            return write_cursor(cursor, [this](EntryView const& item) noexcept {
+                write_string(item.key);
+                writer.write_raw(" = ");
+                write_name(item.name);
+                writer.write_raw(" ");
+                return write_fields(item.fields());
+            });
+        }
+
+        bool write_patches(PatchCursor cursor) noexcept {
+            return write_cursor(cursor, [this](PatchView const& item) noexcept {
+                write_string(item.key);
+                writer.write_raw(" = patch {\n");
+                writer.ident_inc();
+                writer.pad();
+                writer.write_raw("path: string = ");
+                writer.write(item.path);
+                writer.write_raw("\n");
+                writer.pad();
+                writer.write_raw("value: ");
+                if (!write_type(item.value)) {
+                    return false;
+                }
+                writer.write_raw(" = ");
+                if (!write_value(item.value)) {
+                    return false;
+                }
+                writer.write_raw("\n");
+                writer.ident_dec();
+                writer.pad();
+                writer.write_raw("}");
+                return true;
+            });
+        }
+
+        bool write_type(ValueView const& value) noexcept {
+            writer.write(value.type);
+            switch (value.type) {
+            case Type::LIST:
+            case Type::LIST2:
+            case Type::OPTION: {
+                auto const items = value.items();
+                writer.write_raw("[");
+                writer.write(items.valueType);
+                writer.write_raw("]");
+                return items.ok();
+            }
+            case Type::MAP: {
+                auto const pairs = value.pairs();
+                writer.write_raw("[");
+                writer.write(pairs.keyType);
+                writer.write_raw(",");
+                writer.write(pairs.valueType);
+                writer.write_raw("]");
+                return pairs.ok();
+            }
+            default:
+                return true;
+            }
+        }
+
+        template<typename T>
+        bool write_number(ValueView const& value) noexcept {
+            auto item = T {};
+            if (!value.read(item)) {
+                return false;
+            }
+            writer.write(item.value);
+            return true;
+        }
+
+        bool write_value(ValueView const& value) noexcept {
+            switch (value.type) {
+            case Type::NONE:
+                writer.write_raw("null");
+                return true;
+            case Type::BOOL: return write_number<Bool>(value);
+            case Type::I8: return write_number<I8>(value);
+            case Type::U8: return write_number<U8>(value);
+            case Type::I16: return write_number<I16>(value);
+            case Type::U16: return write_number<U16>(value);
+            case Type::I32: return write_number<I32>(value);
+            case Type::U32: return write_number<U32>(value);
+            case Type::I64: return write_number<I64>(value);
+            case Type::U64: return write_number<U64>(value);
+            case Type::F32: return write_number<F32>(value);
+            case Type::VEC2: return write_number<Vec2>(value);
+            case Type::VEC3: return write_number<Vec3>(value);
+            case Type::VEC4: return write_number<Vec4>(value);
+            case Type::MTX44: return write_number<Mtx44>(value);
+            case Type::RGBA: return write_number<RGBA>(value);
+            case Type::FLAG: return write_number<Flag>(value);
+            case Type::STRING: {
+                auto str = std::string_view {};
+                if (!value.read_string(str)) {
+                    return false;
+                }
+                writer.write(str);
+                return true;
+            }
+            case Type::HASH:
+            case Type::LINK: {
+                uint32_t hash = {};
+                if (!value.read_hash(hash)) {
+                    return false;
+                }
+                write_string(hash);
+                return true;
+            }
+            case Type::FILE: {
+                uint64_t hash = {};
+                if (!value.read_hash(hash)) {
+                    return false;
+                }
+                write_string(hash);
+                return true;
+            }
+            case Type::LIST:
+            case Type::LIST2:
+            case Type::OPTION:
+                return write_items(value.items());
+            case Type::MAP:
+                return write_pairs(value.pairs());
+            case Type::POINTER:
+            case Type::EMBED: {
+                uint32_t name = {};
+                if (!value.read_name(name)) {
+                    return false;
+                }
+                if (value.type == Type::POINTER && name == 0) {
+                    writer.write_raw("null");
+                    return true;
+                }
+                write_name(name);
+                writer.write_raw(" ");
+                return write_fields(value.fields());
+            }
+            default:
+                return false;
+            }
+        }
+    };
+}
+
 namespace ritobin::io {
     using namespace text_write_impl;
 
+    std::string write_text(BinView const& view, FILE* out, BinUnhasher const* unhasher, size_t indent_size) noexcept {
+        std::vector<char> buffer;
+        ViewTextWriter writer = { { buffer, indent_size }, out, unhasher, view.data().data() };
+        if (!writer.process_view(view)) {
+            return writer.error;
+        }
+        return {};
+    }
+
     std::string write_text(Bin const& bin, std::vector<char>& out, size_t indent_size) noexcept {
         BinTextWriter writer = { { out, indent_size } };
         if (!writer.process_bin(bin)) {
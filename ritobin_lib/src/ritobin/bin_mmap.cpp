@@ -0,0 +1,131 @@
+#include "bin_mmap.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace ritobin::mmap_impl {
+#ifdef _WIN32
+    static char const* map_file(FILE* file, size_t& size) noexcept {
+        auto const handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+        if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK) {
+            return nullptr;
+        }
+        LARGE_INTEGER file_size = {};
+        if (!GetFileSizeEx(handle, &file_size) || file_size.QuadPart == 0) {
+            return nullptr;
+        }
+        auto const mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            return nullptr;
+        }
+        auto const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) {
+            return nullptr;
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+        return static_cast<char const*>(view);
+    }
+
+    static void unmap_file(char const* data, size_t) noexcept {
+        UnmapViewOfFile(data);
+    }
+#else
+    static char const* map_file(FILE* file, size_t& size) noexcept {
+        auto const fd = fileno(file);
+        struct stat info = {};
+        if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+            return nullptr;
+        }
+        auto const view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            return nullptr;
+        }
+        madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+        size = static_cast<size_t>(info.st_size);
+        return static_cast<char const*>(view);
+    }
+
+    static void unmap_file(char const* data, size_t size) noexcept {
+        munmap(const_cast<char*>(data), size);
+    }
+#endif
+}
+
+namespace ritobin {
+    using namespace mmap_impl;
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          mapped_(std::exchange(other.mapped_, false)),
+          buffer_(std::move(other.buffer_)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            mapped_ = std::exchange(other.mapped_, false);
+            buffer_ = std::move(other.buffer_);
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() noexcept {
+        close();
+    }
+
+    bool MappedFile::map(FILE* file) noexcept {
+        close();
+        if (!file) {
+            return false;
+        }
+        if (auto const view = map_file(file, size_)) {
+            data_ = view;
+            mapped_ = true;
+            return true;
+        }
+        return read(file);
+    }
+
+    bool MappedFile::read(FILE* file) noexcept {
+        close();
+        if (!file) {
+            return false;
+        }
+        size_t size = 0;
+        for (;;) {
+            if (buffer_.size() - size < 4096) {
+                buffer_.resize(buffer_.size() < 0x10000 ? 0x10000 : buffer_.size() * 2);
+            }
+            auto const read = fread(buffer_.data() + size, 1, buffer_.size() - size, file);
+            if (read == 0) {
+                break;
+            }
+            size += read;
+        }
+        buffer_.resize(size);
+        data_ = buffer_.data();
+        size_ = size;
+        return !ferror(file);
+    }
+
+    void MappedFile::close() noexcept {
+        if (mapped_) {
+            unmap_file(data_, size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        buffer_.clear();
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef BIN_MMAP_HPP
+#define BIN_MMAP_HPP
+
+#include <cstdio>
+#include <span>
+#include <vector>
+
+namespace ritobin {
+    struct MappedFile {
+        MappedFile() noexcept = default;
+        MappedFile(MappedFile const&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile() noexcept;
+
+        // Maps whole file, falls back to read() when file can't be mapped (pipes, ttys...)
+        bool map(FILE* file) noexcept;
+
+        // Reads rest of the stream into owned buffer
+        bool read(FILE* file) noexcept;
+
+        void close() noexcept;
+
+        inline char const* data() const noexcept {
+            return data_;
+        }
+
+        inline size_t size() const noexcept {
+            return size_;
+        }
+
+        inline bool is_mapped() const noexcept {
+            return mapped_;
+        }
+
+        inline std::span<char const> span() const noexcept {
+            return { data_, size_ };
+        }
+
+        inline operator std::span<char const>() const noexcept {
+            return span();
+        }
+    private:
+        char const* data_ = {};
+        size_t size_ = {};
+        bool mapped_ = {};
+        std::vector<char> buffer_ = {};
+    };
+}
+
+#endif // BIN_MMAP_HPP
@@ -169,7 +169,9 @@ namespace ritobin {
     template <typename FromT, typename IntoT>
     struct morph_value_impl<FromT, IntoT, Category::NUMBER, Category::STRING> {
         static MorphResult morph (FromT& from, IntoT& into) {
-            if (from_num(into.value, from.value)) {
+            char buffer[FROM_NUM_MAX];
+            if (auto const end = from_num(buffer, buffer + sizeof(buffer), from.value)) {
+                into.value.assign(buffer, end);
                 return MorphResult::OK;
             } else {
                 return MorphResult::OK;
@@ -288,7 +290,9 @@ namespace ritobin {
     template <typename FromT, typename IntoT>
     struct morph_value_impl<FromT, IntoT, Category::VECTOR, Category::STRING> {
         static MorphResult morph (FromT& from, IntoT& into) {
-            if (from_num(into.value, from.value.front())) {
+            char buffer[FROM_NUM_MAX];
+            if (auto const end = from_num(buffer, buffer + sizeof(buffer), from.value.front())) {
+                into.value.assign(buffer, end);
                 return MorphResult::LOSSY;
             } else {
                 return MorphResult::LOSSY;
@@ -492,7 +496,7 @@ namespace ritobin {
     struct morph_value_impl<FromT, IntoT, Category::HASH, Category::STRING> {
         static MorphResult morph (FromT& from, IntoT& into) {
             if (auto str = from.value.str(); !str.empty()) {
-                into.value = std::move(from.value).str();
+                into.value = str;
                 return MorphResult::OK;
             } else if (from.value.hash() == 0) {
                 return MorphResult::OK;
@@ -512,7 +516,7 @@ namespace ritobin {
                 into.value = std::move(from.value);
                 return MorphResult::OK;
             } else if (auto str = from.value.str(); !str.empty()) {
-                into.value = std::move(from.value).str();
+                into.value = str;
                 return MorphResult::OK;
             } else {
                 using into_storage_t = typename decltype(into.value)::storage_t;
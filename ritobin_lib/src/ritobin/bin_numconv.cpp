@@ -1,18 +1,56 @@
 #include "bin_numconv.hpp"
+#include <algorithm>
 
 #ifdef RITOBIN_NO_CHARCONV_FLOAT
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+namespace ritobin::numconv_impl {
+    // Uses fewest significant digits that still read back as same value, like to_chars does
+    template<typename T>
+    static char* from_float(char* first, char* last, T num, int min_digits, int max_digits) noexcept {
+        char buffer[64];
+        int size = 0;
+        for (int digits = min_digits; digits <= max_digits; digits++) {
+            size = snprintf(buffer, sizeof(buffer), "%.*g", digits, static_cast<double>(num));
+            if (size <= 0 || static_cast<size_t>(size) >= sizeof(buffer)) {
+                return nullptr;
+            }
+            if constexpr (std::is_same_v<T, float>) {
+                if (strtof(buffer, nullptr) == num) {
+                    break;
+                }
+            } else {
+                if (strtod(buffer, nullptr) == num) {
+                    break;
+                }
+            }
+        }
+        if (last - first < size) {
+            return nullptr;
+        }
+        memcpy(first, buffer, static_cast<size_t>(size));
+        return first + size;
+    }
+}
+
 namespace ritobin {
+    using namespace numconv_impl;
+
     bool to_num(std::string_view str, float& num) noexcept {
         auto copy = std::string(str.begin(), str.end());
         return sscanf(copy.c_str(), "%g", &num) == 1;
     }
 
+    char* from_num(char* first, char* last, float const& num) noexcept {
+        return from_float(first, last, num, 6, 9);
+    }
+
     bool from_num(std::string& str, float const& num) noexcept {
-        char buffer[64] = {};
-        auto const size = sprintf(buffer, "%.9g", num);
-        str = std::string(buffer, buffer + size);
-        return true;
+        char buffer[FROM_NUM_MAX];
+        auto const end = from_num(buffer, buffer + sizeof(buffer), num);
+        str.assign(buffer, end ? end : buffer);
+        return end != nullptr;
     }
 
     bool to_num(std::string_view str, double& num) noexcept {
@@ -20,11 +58,15 @@ namespace ritobin {
         return sscanf(copy.c_str(), "%lg", &num) == 1;
     }
 
+    char* from_num(char* first, char* last, double const& num) noexcept {
+        return from_float(first, last, num, 15, 17);
+    }
+
     bool from_num(std::string& str, double const& num) noexcept {
-        char buffer[64] = {};
-        auto const size = sprintf(buffer, "%.17lg", num);
-        str = std::string(buffer, buffer + size);
-        return true;
+        char buffer[FROM_NUM_MAX];
+        auto const end = from_num(buffer, buffer + sizeof(buffer), num);
+        str.assign(buffer, end ? end : buffer);
+        return end != nullptr;
     }
 }
 #endif
@@ -52,6 +94,14 @@ namespace ritobin {
         }
     }
 
+    char* from_num(char* first, char* last, bool const& num) noexcept {
+        auto const str = std::string_view{ num ? "true" : "false" };
+        if (static_cast<size_t>(last - first) < str.size()) {
+            return nullptr;
+        }
+        return std::copy(str.begin(), str.end(), first);
+    }
+
     bool from_num(std::string& str, bool const& num) noexcept {
         str = num ? "true" : "false";
         return true;
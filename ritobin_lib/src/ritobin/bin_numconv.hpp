@@ -3,14 +3,23 @@
 #include <charconv>
 #include <string>
 
+namespace ritobin {
+    // Enough chars for from_num of any arithmetic type in any base
+    inline constexpr size_t FROM_NUM_MAX = 72;
+}
+
 #ifdef RITOBIN_NO_CHARCONV_FLOAT
 namespace ritobin {
     extern bool to_num(std::string_view str, float& num) noexcept;
 
+    extern char* from_num(char* first, char* last, float const& num) noexcept;
+
     extern bool from_num(std::string& str, float const& num) noexcept;
 
     extern bool to_num(std::string_view str, double& num) noexcept;
 
+    extern char* from_num(char* first, char* last, double const& num) noexcept;
+
     extern bool from_num(std::string& str, double const& num) noexcept;
 }
 #endif
@@ -32,27 +41,32 @@ namespace ritobin {
         return false;
     }
 
+    // Writes num into [first, last), returns end of written chars or nullptr when it does not fit
     template<typename T>
-    inline bool from_num(std::string& str, T const& num, int base = 10) noexcept {
-        char buffer[256] = {};
+    inline char* from_num(char* first, char* last, T const& num, int base = 10) noexcept {
         if constexpr (std::is_floating_point_v<T>) {
-            auto const [p, ec] = std::to_chars(buffer, buffer + sizeof(buffer), num);
-            if (ec == std::errc{}) {
-                str = std::string(buffer, p);
-                return true;
-            }
+            auto const [p, ec] = std::to_chars(first, last, num);
+            return ec == std::errc{} ? p : nullptr;
         } else {
-            auto const [p, ec] = std::to_chars(buffer, buffer + sizeof(buffer), num, base);
-            if (ec == std::errc{}) {
-                str = std::string(buffer, p);
-                return true;
-            }
+            auto const [p, ec] = std::to_chars(first, last, num, base);
+            return ec == std::errc{} ? p : nullptr;
+        }
+    }
+
+    template<typename T>
+    inline bool from_num(std::string& str, T const& num, int base = 10) noexcept {
+        char buffer[FROM_NUM_MAX];
+        if (auto const end = from_num(buffer, buffer + sizeof(buffer), num, base)) {
+            str.assign(buffer, end);
+            return true;
         }
         return false;
     }
 
     extern bool to_num(std::string_view str, bool& num) noexcept;
 
+    extern char* from_num(char* first, char* last, bool const& num) noexcept;
+
     extern bool from_num(std::string& str, bool const& num) noexcept;
 }
 
@@ -0,0 +1,52 @@
+#ifndef BIN_PARALLEL_HPP
+#define BIN_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "bin_arena.hpp"
+#include "bin_hash.hpp"
+
+namespace ritobin {
+    // Runs func(i) for every i in [0, count) on up to jobs threads, calling thread included.
+    // Work is handed out in order and stops on first failure.
+    // Returns lowest index for which func returned false, or count when all succeeded.
+    // Workers intern names into same pool as calling thread and allocate values from its resource,
+    // or from their own fork of it when it is BinArena.
+    template<typename F>
+    inline size_t parallel_for(size_t count, size_t jobs, F&& func) noexcept {
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> failed = count;
+        auto const names = InternPool::Scope::current();
+        auto const resource = BinArenaScope::current();
+        auto const arena = dynamic_cast<BinArena*>(resource);
+        auto worker = [&](std::pmr::memory_resource* worker_resource) noexcept {
+            auto const names_scope = InternPool::Scope { names };
+            auto const arena_scope = BinArenaScope { worker_resource };
+            for (size_t i = next++; i < count; i = next++) {
+                if (!func(i)) {
+                    auto lowest = failed.load();
+                    while (i < lowest && !failed.compare_exchange_weak(lowest, i)) {}
+                    next = count;
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        auto const thread_count = std::min(jobs, count);
+        for (size_t i = 1; i < thread_count; i++) {
+            try {
+                threads.emplace_back(worker, arena ? arena->fork() : resource);
+            } catch (...) {
+                break;
+            }
+        }
+        worker(resource);
+        for (auto& thread: threads) {
+            thread.join();
+        }
+        return failed;
+    }
+}
+
+#endif // BIN_PARALLEL_HPP
@@ -5,12 +5,46 @@
 #include <span>
 #include <inttypes.h>
 
+#if !defined(RITOBIN_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define RITOBIN_STRCONV_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace ritobin::strconv_impl {
     // TODO: handle unicode shit properly
 
+    // Length of longest prefix that has no a, no b and, when control is set, no bytes below 0x20
+    static size_t plain_prefix(std::string_view data, char a, char b, bool control) noexcept {
+        size_t i = 0;
+#ifdef RITOBIN_STRCONV_SSE2
+        auto const va = _mm_set1_epi8(a);
+        auto const vb = _mm_set1_epi8(b);
+        auto const limit = _mm_set1_epi8(0x1F);
+        for (; i + 16 <= data.size(); i += 16) {
+            auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(data.data() + i));
+            auto m = _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb));
+            if (control) {
+                // unsigned v <= 0x1F
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(v, limit), limit));
+            }
+            if (auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(m))) {
+                return i + std::countr_zero(mask);
+            }
+        }
+#endif
+        for (; i != data.size(); i++) {
+            auto const c = data[i];
+            if (c == a || c == b || (control && (uint8_t)c < 0x20)) {
+                break;
+            }
+        }
+        return i;
+    }
+
     using escape_pair = std::pair<std::string_view, std::string_view>;
 
-    static void write_utf8(std::string& out, uint32_t value) noexcept {
+    template<typename S>
+    static void write_utf8(S& out, uint32_t value) noexcept {
         if (value < 0x80) {
             out += { (char)value };
         } else if (value < 0x800) {
@@ -43,6 +77,13 @@ namespace ritobin::strconv_impl {
             return data_.data();
         }
 
+        // Skips and returns chars up to next a, b or control char
+        std::string_view take_plain(char a, char b, bool control) noexcept {
+            auto const result = data_.substr(0, plain_prefix(data_, a, b, control));
+            data_.remove_prefix(result.size());
+            return result;
+        }
+
         size_t left() const noexcept {
             return data_.size();
         }
@@ -98,10 +139,16 @@ namespace ritobin::strconv_impl {
         }
     };
 
+    template<typename S>
     struct StringUnquote {
         StringIterator iter;
-        void process(std::string& out) noexcept {
+
+        void process(S& out) noexcept {
             while (iter.left()) {
+                out += iter.take_plain('\\', '\\', true);
+                if (!iter.left()) {
+                    break;
+                }
                 if (!read_unicode_unescape(out)) {
                     break;
                 }
@@ -114,7 +161,7 @@ namespace ritobin::strconv_impl {
         // reads utf16 escape, returns false on error
         // if you wonder why this looks so "complex":
         // https://en.wikipedia.org/wiki/UTF-16#Code_points_from_U+010000_to_U+10FFFF
-        bool read_unicode_unescape(std::string& out) noexcept {
+        bool read_unicode_unescape(S& out) noexcept {
             uint32_t last = 0;
             while (iter.match_str("\\u")) {
                 if (auto value = iter.match_hex(4)) {
@@ -147,7 +194,7 @@ namespace ritobin::strconv_impl {
         }
 
         // read simple escapes, returns false on error
-        bool read_simple_unescape(std::string& out) noexcept {
+        bool read_simple_unescape(S& out) noexcept {
             constexpr escape_pair const escapes[] = {
                 { "\\'", "\'" },
                 { "\\\"", "\"" },
@@ -191,8 +238,14 @@ namespace ritobin::strconv_impl {
         StringIterator iter;
 
         void process(std::vector<char>& out) noexcept {
+            out.reserve(out.size() + iter.left() + 2);
             out.push_back('"');
             while(iter.left()) {
+                auto const plain = iter.take_plain('\\', '"', true);
+                out.insert(out.end(), plain.begin(), plain.end());
+                if (!iter.left()) {
+                    break;
+                }
                 if (!write_simple_escape(out)) {
                     break;
                 }
@@ -244,14 +297,27 @@ namespace ritobin {
 
     char const* str_unquote_fetch_end(std::string_view data) noexcept {
         auto iter = StringIterator { data };
-        for (auto quote = iter.pop(); iter.left() && iter.peek() != quote; iter.pop()) {
-            iter.match_str("\\");
+        if (auto const quote = iter.pop()) {
+            while (iter.left()) {
+                iter.take_plain(*quote, '\\', false);
+                if (!iter.left() || iter.peek() == quote) {
+                    break;
+                }
+                iter.pop();
+                iter.pop();
+            }
         }
         return iter.data();
     }
 
     char const* str_unquote(std::string_view data, std::string& out) noexcept {
-        auto unquote = StringUnquote { { data } };
+        auto unquote = StringUnquote<std::string> { { data } };
+        unquote.process(out);
+        return unquote.iter.data();
+    }
+
+    char const* str_unquote(std::string_view data, BinString& out) noexcept {
+        auto unquote = StringUnquote<BinString> { { data } };
         unquote.process(out);
         return unquote.iter.data();
     }
@@ -4,12 +4,15 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include "bin_arena.hpp"
 
 namespace ritobin {
     extern char const* str_unquote_fetch_end(std::string_view data) noexcept;
 
     extern char const* str_unquote(std::string_view data, std::string& out) noexcept;
 
+    extern char const* str_unquote(std::string_view data, BinString& out) noexcept;
+
     extern char const* str_quote(std::string_view data, std::vector<char>& out) noexcept;
 }
 
@@ -0,0 +1,143 @@
+#include "bin_types.hpp"
+#include "bin_types_helper.hpp"
+#include <bit>
+
+namespace ritobin {
+    namespace {
+        template<typename T>
+        void reintern_name(T& hash) {
+            if (auto const str = hash.str(); !str.empty()) {
+                hash = T(str);
+            }
+        }
+
+        // Moves names of every hashed value into pool in scope
+        void reintern(Value& value) {
+            std::visit([](auto& value) {
+                using value_t = std::remove_cvref_t<decltype(value)>;
+                if constexpr (std::is_same_v<value_t, Hash> || std::is_same_v<value_t, File>
+                              || std::is_same_v<value_t, Link>) {
+                    reintern_name(value.value);
+                } else if constexpr (value_t::category == Category::CLASS) {
+                    reintern_name(value.name);
+                    for (auto& [key, item]: value.items) {
+                        reintern_name(key);
+                        reintern(item);
+                    }
+                } else if constexpr (value_t::category == Category::LIST || value_t::category == Category::OPTION) {
+                    // Packed numbers and vectors have no names
+                    if (value.items.packed_type() == Type::NONE) {
+                        for (auto& [item]: value.items) {
+                            reintern(item);
+                        }
+                    }
+                } else if constexpr (value_t::category == Category::MAP) {
+                    for (auto& [key, item]: value.items) {
+                        reintern(key);
+                        reintern(item);
+                    }
+                }
+            }, value);
+        }
+    }
+
+    Bin ArenaBin::copy() const {
+        auto const arena_scope = BinArenaScope { std::pmr::get_default_resource() };
+        auto const names_scope = InternPool::Scope { nullptr };
+        auto result = bin_;
+        for (auto& [name, value]: result.sections) {
+            reintern(value);
+        }
+        return result;
+    }
+
+    void FieldList::build_index() noexcept {
+        // Open addressing table twice the field count, first field wins when key repeats
+        if (size() < index_min_size) {
+            return;
+        }
+        auto const& fields = static_cast<storage_type const&>(*this);
+        auto const capacity = std::bit_ceil(size() * 2);
+        index_.assign(capacity, 0);
+        for (size_t i = 0; i != size(); i++) {
+            auto const key = fields[i].key.hash();
+            for (size_t slot = index_slot(key, capacity);; slot = (slot + 1) & (capacity - 1)) {
+                if (index_[slot] == 0) {
+                    index_[slot] = uint64_t{ key } << 32 | (i + 1);
+                    break;
+                }
+                if (static_cast<uint32_t>(index_[slot] >> 32) == key) {
+                    break;
+                }
+            }
+        }
+    }
+
+    Field const* FieldList::find_indexed(uint32_t hash) const noexcept {
+        auto const capacity = index_.size();
+        for (size_t slot = index_slot(hash, capacity);; slot = (slot + 1) & (capacity - 1)) {
+            auto const entry = index_[slot];
+            if (entry == 0) {
+                return nullptr;
+            }
+            if (static_cast<uint32_t>(entry >> 32) == hash) {
+                return &(*this)[static_cast<uint32_t>(entry) - 1];
+            }
+        }
+    }
+
+    bool ElementList::pack(Type type) {
+        if (packed_type_ != Type::NONE) {
+            return packed_type_ == type;
+        }
+        return std::visit([this](auto&& prototype) -> bool {
+            using value_t = std::remove_cvref_t<decltype(prototype)>;
+            if constexpr (is_packable<value_t>) {
+                for (auto const& item: items_) {
+                    if (!std::holds_alternative<value_t>(item.value)) {
+                        return false;
+                    }
+                }
+                auto items = std::move(items_);
+                items_.clear();
+                auto const values = assign_packed<value_t>(items.size());
+                for (size_t i = 0; i != values.size(); i++) {
+                    values[i] = std::get<value_t>(items[i].value).value;
+                }
+                return true;
+            } else {
+                return false;
+            }
+        }, ValueHelper::type_to_value(type));
+    }
+
+    void ElementList::decode(size_t index, Element& out) const {
+        std::visit([this, index, &out](auto&& prototype) {
+            using value_t = std::remove_cvref_t<decltype(prototype)>;
+            if constexpr (is_packable<value_t>) {
+                out.value = value_t { packed<value_t>()[index] };
+            }
+        }, ValueHelper::type_to_value(packed_type_));
+    }
+
+    void ElementList::unpack_values() {
+        std::visit([this](auto&& prototype) {
+            using value_t = std::remove_cvref_t<decltype(prototype)>;
+            if constexpr (is_packable<value_t>) {
+                auto const values = std::span<decltype(value_t::value) const> {
+                    reinterpret_cast<decltype(value_t::value) const*>(packed_.data()),
+                    packed_size_
+                };
+                items_.clear();
+                items_.reserve(values.size());
+                for (auto const& value: values) {
+                    items_.emplace_back(value_t { value });
+                }
+            }
+        }, ValueHelper::type_to_value(packed_type_));
+        packed_.clear();
+        packed_.shrink_to_fit();
+        packed_size_ = 0;
+        packed_type_ = Type::NONE;
+    }
+}
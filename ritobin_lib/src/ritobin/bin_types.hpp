@@ -3,13 +3,18 @@
 
 #include <array>
 #include <cstdint>
+#include <cstddef>
 #include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "bin_arena.hpp"
 #include "bin_flatmap.hpp"
 #include "bin_hash.hpp"
 
@@ -60,9 +65,137 @@ namespace ritobin {
     struct Field;
     struct Pair;
 
-    using ElementList = std::vector<Element>;
-    using FieldList = std::vector<Field>;
-    using PairList = std::vector<Pair>;
+    // Numbers and vectors have fixed width values that can be stored without Element around them
+    template<typename T>
+    inline constexpr bool is_packable = T::category == Category::NUMBER || T::category == Category::VECTOR;
+
+    // Items of List, List2 and Option.
+    // Items of number or vector type can be held packed as contiguous values instead of Elements.
+    // Every non-const accessor that hands out Element unpacks them first, const iteration decodes packed
+    // values one at a time without changing list, so code written against Elements keeps working while
+    // hot paths go through packed<T>() directly.
+    struct ElementList {
+        using value_type = Element;
+        using storage_type = std::vector<Element, BinAllocator<Element>>;
+        using iterator = storage_type::iterator;
+        struct const_iterator;
+
+        ElementList() = default;
+        ElementList(std::initializer_list<Element> items);
+        ElementList& operator=(std::initializer_list<Element> items);
+
+        inline size_t size() const noexcept;
+        inline bool empty() const noexcept;
+        inline iterator begin();
+        inline iterator end();
+        inline const_iterator begin() const;
+        inline const_iterator end() const;
+        inline Element& front();
+        inline Element& back();
+        inline Element& operator[](size_t index);
+        template<typename... Args>
+        inline Element& emplace_back(Args&&... args);
+        inline void reserve(size_t count);
+        inline void resize(size_t count);
+        inline void clear() noexcept;
+
+        // Item type of packed values, NONE when items are held as Elements
+        Type packed_type() const noexcept { return packed_type_; }
+
+        // Packed values when items are packed as T
+        template<typename T>
+        inline std::span<decltype(T::value) const> packed() const noexcept;
+
+        template<typename T>
+        inline std::span<decltype(T::value)> packed() noexcept;
+
+        // Replaces items with count packed values of T that caller fills in
+        template<typename T>
+        inline std::span<decltype(T::value)> assign_packed(size_t count);
+
+        // Packs Elements if all of them are of packable type, returns true when items end up packed
+        bool pack(Type type);
+
+        // Turns packed values back into Elements
+        void unpack() {
+            if (packed_type_ != Type::NONE) {
+                unpack_values();
+            }
+        }
+    private:
+        struct alignas(8) PackedWord {
+            std::byte bytes[8];
+        };
+
+        void unpack_values();
+
+        // Writes packed value at index into out
+        void decode(size_t index, Element& out) const;
+
+        storage_type items_ = {};
+        std::vector<PackedWord, BinAllocator<PackedWord>> packed_ = {};
+        size_t packed_size_ = {};
+        Type packed_type_ = Type::NONE;
+    };
+
+    // Fields of Pointer and Embed in serialization order.
+    // Wide classes get a hash table of field positions on the side, built by build_index() or first non-const
+    // find and dropped by every other non-const access since that may change keys.
+    // Const access never builds it, so lists shared between threads are only ever read.
+    struct FieldList : private std::vector<Field, BinAllocator<Field>> {
+        using storage_type = std::vector<Field, BinAllocator<Field>>;
+        using typename storage_type::value_type;
+        using typename storage_type::size_type;
+        using typename storage_type::iterator;
+        using typename storage_type::const_iterator;
+        using storage_type::storage_type;
+        using storage_type::size;
+        using storage_type::empty;
+        using storage_type::capacity;
+        using storage_type::reserve;
+
+        inline const_iterator begin() const noexcept;
+        inline const_iterator end() const noexcept;
+        inline Field const& front() const noexcept;
+        inline Field const& back() const noexcept;
+        inline Field const& operator[](size_t index) const noexcept;
+        inline iterator begin() noexcept;
+        inline iterator end() noexcept;
+        inline Field& front() noexcept;
+        inline Field& back() noexcept;
+        inline Field& operator[](size_t index) noexcept;
+        template<typename... Args>
+        inline Field& emplace_back(Args&&... args);
+        inline void push_back(Field const& field);
+        inline void push_back(Field&& field);
+        inline iterator insert(const_iterator pos, Field field);
+        inline iterator erase(const_iterator pos);
+        inline iterator erase(const_iterator first, const_iterator last);
+        inline void resize(size_t count);
+        inline void clear() noexcept;
+
+        // First field with key, nullptr when there is none
+        inline Field const* find(FNV1a const& key) const noexcept;
+        // Same as above but builds index first, key of returned field must not be changed through it
+        inline Field* find(FNV1a const& key) noexcept;
+
+        // Builds index when list is wide enough to benefit from it
+        void build_index() noexcept;
+    private:
+        // Below this many fields linear scan beats building index
+        static inline constexpr size_t index_min_size = 48;
+
+        static size_t index_slot(uint32_t hash, size_t capacity) noexcept {
+            return (hash * uint64_t{ 0x9E3779B97F4A7C15u } >> 32) & (capacity - 1);
+        }
+
+        Field const* find_indexed(uint32_t hash) const noexcept;
+
+        // key hash << 32 | position + 1, 0 marks empty slot
+        std::vector<uint64_t, BinAllocator<uint64_t>> index_ = {};
+    };
+
+    using PairList = std::vector<Pair, BinAllocator<Pair>>;
 
     struct None {
         static inline constexpr Type type = Type::NONE;
@@ -184,7 +317,7 @@ namespace ritobin {
         static inline constexpr Type type = Type::STRING;
         static inline constexpr char type_name[] = "string";
         static inline constexpr Category category = Category::STRING;
-        std::string value = {};
+        BinString value = {};
     };
 
     struct Hash {
@@ -321,35 +454,160 @@ namespace ritobin {
         Field(FNV1a key, Value value);
     };
 
-    inline Field* Pointer::find_field(FNV1a const& key) noexcept {
-        for (auto& field: items) {
-            if (field.key.hash() == key.hash()) {
-                return &field;
+    // Elements of list as they are or packed values decoded into slot owned by iterator,
+    // references to those stay valid until iterator moves.
+    struct ElementList::const_iterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Element;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Element const*;
+        using reference = Element const&;
+
+        const_iterator() = default;
+
+        reference operator*() const {
+            if (list_->packed_type_ == Type::NONE) {
+                return list_->items_[index_];
             }
+            list_->decode(index_, slot_);
+            return slot_;
         }
-        return nullptr;
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            auto result = *this;
+            ++index_;
+            return result;
+        }
+
+        bool operator==(const_iterator const& other) const noexcept {
+            return index_ == other.index_;
+        }
+    private:
+        friend ElementList;
+
+        const_iterator(ElementList const* list, size_t index) noexcept : list_(list), index_(index) {}
+
+        ElementList const* list_ = {};
+        size_t index_ = {};
+        mutable Element slot_ = {};
+    };
+
+    inline Field* Pointer::find_field(FNV1a const& key) noexcept {
+        return items.find(key);
     }
 
     inline Field const* Pointer::find_field(FNV1a const& key) const noexcept {
-        for (auto const& field: items) {
-            if (field.key.hash() == key.hash()) {
-                return &field;
-            }
-        }
-        return nullptr;
+        return items.find(key);
     }
 
     inline Field* Embed::find_field(FNV1a const& key) noexcept {
-        for (auto& field: items) {
-            if (field.key.hash() == key.hash()) {
-                return &field;
-            }
-        }
-        return nullptr;
+        return items.find(key);
     }
 
     inline Field const* Embed::find_field(FNV1a const& key) const noexcept {
-        for (auto const& field: items) {
+        return items.find(key);
+    }
+
+    inline FieldList::const_iterator FieldList::begin() const noexcept {
+        return storage_type::begin();
+    }
+
+    inline FieldList::const_iterator FieldList::end() const noexcept {
+        return storage_type::end();
+    }
+
+    inline Field const& FieldList::front() const noexcept {
+        return storage_type::front();
+    }
+
+    inline Field const& FieldList::back() const noexcept {
+        return storage_type::back();
+    }
+
+    inline Field const& FieldList::operator[](size_t index) const noexcept {
+        return storage_type::operator[](index);
+    }
+
+    inline FieldList::iterator FieldList::begin() noexcept {
+        index_.clear();
+        return storage_type::begin();
+    }
+
+    inline FieldList::iterator FieldList::end() noexcept {
+        index_.clear();
+        return storage_type::end();
+    }
+
+    inline Field& FieldList::front() noexcept {
+        index_.clear();
+        return storage_type::front();
+    }
+
+    inline Field& FieldList::back() noexcept {
+        index_.clear();
+        return storage_type::back();
+    }
+
+    inline Field& FieldList::operator[](size_t index) noexcept {
+        index_.clear();
+        return storage_type::operator[](index);
+    }
+
+    template<typename... Args>
+    inline Field& FieldList::emplace_back(Args&&... args) {
+        index_.clear();
+        return storage_type::emplace_back(std::forward<Args>(args)...);
+    }
+
+    inline void FieldList::push_back(Field const& field) {
+        index_.clear();
+        storage_type::push_back(field);
+    }
+
+    inline void FieldList::push_back(Field&& field) {
+        index_.clear();
+        storage_type::push_back(std::move(field));
+    }
+
+    inline FieldList::iterator FieldList::insert(const_iterator pos, Field field) {
+        index_.clear();
+        return storage_type::insert(pos, std::move(field));
+    }
+
+    inline FieldList::iterator FieldList::erase(const_iterator pos) {
+        index_.clear();
+        return storage_type::erase(pos);
+    }
+
+    inline FieldList::iterator FieldList::erase(const_iterator first, const_iterator last) {
+        index_.clear();
+        return storage_type::erase(first, last);
+    }
+
+    inline void FieldList::resize(size_t count) {
+        index_.clear();
+        storage_type::resize(count);
+    }
+
+    inline void FieldList::clear() noexcept {
+        index_.clear();
+        storage_type::clear();
+    }
+
+    inline Field const* FieldList::find(FNV1a const& key) const noexcept {
+        if (!index_.empty()) {
+            return find_indexed(key.hash());
+        }
+        for (auto const& field: *this) {
             if (field.key.hash() == key.hash()) {
                 return &field;
             }
@@ -357,6 +615,112 @@ namespace ritobin {
         return nullptr;
     }
 
+    inline Field* FieldList::find(FNV1a const& key) noexcept {
+        if (index_.empty()) {
+            build_index();
+        }
+        return const_cast<Field*>(static_cast<FieldList const&>(*this).find(key));
+    }
+
+    inline ElementList::ElementList(std::initializer_list<Element> items) : items_(items) {}
+
+    inline ElementList& ElementList::operator=(std::initializer_list<Element> items) {
+        clear();
+        items_ = items;
+        return *this;
+    }
+
+    inline size_t ElementList::size() const noexcept {
+        return packed_type_ != Type::NONE ? packed_size_ : items_.size();
+    }
+
+    inline bool ElementList::empty() const noexcept {
+        return size() == 0;
+    }
+
+    inline ElementList::iterator ElementList::begin() {
+        unpack();
+        return items_.begin();
+    }
+
+    inline ElementList::iterator ElementList::end() {
+        unpack();
+        return items_.end();
+    }
+
+    inline ElementList::const_iterator ElementList::begin() const {
+        return { this, 0 };
+    }
+
+    inline ElementList::const_iterator ElementList::end() const {
+        return { this, size() };
+    }
+
+    inline Element& ElementList::front() {
+        unpack();
+        return items_.front();
+    }
+
+    inline Element& ElementList::back() {
+        unpack();
+        return items_.back();
+    }
+
+    inline Element& ElementList::operator[](size_t index) {
+        unpack();
+        return items_[index];
+    }
+
+    template<typename... Args>
+    inline Element& ElementList::emplace_back(Args&&... args) {
+        unpack();
+        return items_.emplace_back(std::forward<Args>(args)...);
+    }
+
+    inline void ElementList::reserve(size_t count) {
+        unpack();
+        items_.reserve(count);
+    }
+
+    inline void ElementList::resize(size_t count) {
+        unpack();
+        items_.resize(count);
+    }
+
+    inline void ElementList::clear() noexcept {
+        items_.clear();
+        packed_.clear();
+        packed_size_ = 0;
+        packed_type_ = Type::NONE;
+    }
+
+    template<typename T>
+    inline std::span<decltype(T::value) const> ElementList::packed() const noexcept {
+        if (packed_type_ != T::type) {
+            return {};
+        }
+        return { reinterpret_cast<decltype(T::value) const*>(packed_.data()), packed_size_ };
+    }
+
+    template<typename T>
+    inline std::span<decltype(T::value)> ElementList::packed() noexcept {
+        if (packed_type_ != T::type) {
+            return {};
+        }
+        return { reinterpret_cast<decltype(T::value)*>(packed_.data()), packed_size_ };
+    }
+
+    template<typename T>
+    inline std::span<decltype(T::value)> ElementList::assign_packed(size_t count) {
+        static_assert(is_packable<T>);
+        static_assert(alignof(decltype(T::value)) <= alignof(PackedWord));
+        clear();
+        packed_.resize((count * sizeof(T::value) + sizeof(PackedWord) - 1) / sizeof(PackedWord));
+        packed_size_ = count;
+        packed_type_ = T::type;
+        return packed<T>();
+    }
+
     inline Element::Element() : value{} {}
     inline Element::Element(Value value) : value(std::move(value)) {}
 
@@ -370,6 +734,33 @@ namespace ritobin {
         static inline constexpr char type_name[] = "sections";
         flatmap<std::string, Value> sections;
     };
+
+    // Bin whose values and hash names are allocated from owned arena and pool and released together with them.
+    // Values have to be created inside scope(). Values of bin() still point into arena when moved out,
+    // copy() is the only way to keep tree after ArenaBin is gone.
+    struct ArenaBin {
+        struct Scope {
+            BinArenaScope arena;
+            InternPool::Scope names;
+        };
+
+        explicit ArenaBin(size_t initial_size = 64 * 1024) noexcept : arena_(initial_size) {}
+        ArenaBin(ArenaBin const&) = delete;
+        ArenaBin& operator=(ArenaBin const&) = delete;
+
+        Scope scope() noexcept { return Scope { BinArenaScope { &arena_ }, InternPool::Scope { &names_ } }; }
+
+        Bin& bin() & noexcept { return bin_; }
+        Bin const& bin() const& noexcept { return bin_; }
+        void bin() && = delete;
+
+        // Copy of tree with values on default resource and names in global pool
+        Bin copy() const;
+    private:
+        BinArena arena_;
+        InternPool names_;
+        Bin bin_;
+    };
 }
 
 #endif // BIN_TYPES_HPP
@@ -1,10 +1,357 @@
 #include <fstream>
 #include <charconv>
+#include <cstring>
 #include <string>
 #include <filesystem>
+#include <algorithm>
 #include "bin_unhash.hpp"
+#include "bin_view.hpp"
+#include "bin_types_helper.hpp"
+
+namespace ritobin::unhash_impl {
+    static inline constexpr char DB_MAGIC[4] = { 'R', 'H', 'D', 'B' };
+    static inline constexpr uint32_t DB_VERSION = 1;
+    static inline constexpr size_t DB_HEADER_SIZE = 16;
+
+    template<typename T>
+    static inline T read_raw(char const* data) noexcept {
+        T result;
+        memcpy(&result, data, sizeof(T));
+        return result;
+    }
+
+    // Parses "hash name" lines, stops at first empty line or once every wanted hash is found
+    template<typename T>
+    struct CDTBParser {
+        std::unordered_map<T, std::string>& out;
+        std::unordered_set<T> const* wanted;
+        size_t missing = 0;
+
+        CDTBParser(std::unordered_map<T, std::string>& out, std::unordered_set<T> const* wanted) noexcept
+            : out(out), wanted(wanted) {
+            if (wanted) {
+                for (auto hash: *wanted) {
+                    missing += !out.contains(hash);
+                }
+            }
+        }
+
+        bool done() const noexcept {
+            return wanted && missing == 0;
+        }
+
+        // Returns false when rest of input should be skipped
+        bool line(std::string_view line) noexcept {
+            if (line.empty()) {
+                return false;
+            }
+            auto const space = line.find_first_of(' ');
+            if (space == std::string_view::npos) {
+                return true;
+            }
+            auto hash = T{};
+            std::from_chars(line.data(), line.data() + space, hash, 16);
+            if (wanted) {
+                if (!wanted->contains(hash)) {
+                    return true;
+                }
+                missing -= !out.contains(hash);
+            }
+            out[hash] = line.substr(space + 1);
+            return !done();
+        }
+    };
+
+    template<typename T>
+    static bool load_CDTB(std::istream& istream, std::unordered_map<T, std::string>& out,
+                          std::unordered_set<T> const* wanted) noexcept {
+        if (!istream) {
+            return false;
+        }
+        auto parser = CDTBParser<T> { out, wanted };
+        auto line = std::string{};
+        while (!parser.done() && std::getline(istream, line) && parser.line(line)) {}
+        return true;
+    }
+
+    template<typename T>
+    static bool load_CDTB_file(std::string const& filename, CDTBParser<T>& parser) noexcept {
+        auto file = fopen(filename.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        MappedFile data = {};
+        auto const ok = data.map(file);
+        fclose(file);
+        if (!ok) {
+            return false;
+        }
+        for (auto rest = std::string_view{ data.data(), data.size() }; !rest.empty() && !parser.done();) {
+            auto const end = std::min(rest.find('\n'), rest.size());
+            if (!parser.line(rest.substr(0, end))) {
+                break;
+            }
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+        }
+        return true;
+    }
+
+    // Loads filename or, when missing, its parts filename.0, filename.1 ...
+    template<typename T>
+    static bool load_CDTB(std::string const& filename, std::unordered_map<T, std::string>& out,
+                          std::unordered_set<T> const* wanted) noexcept {
+        auto parser = CDTBParser<T> { out, wanted };
+        if (load_CDTB_file(filename, parser)) {
+            return true;
+        }
+        bool had_some = false;
+        for (size_t i = 0; !parser.done(); i++) {
+            if (!load_CDTB_file(filename + "." + std::to_string(i), parser)) {
+                break;
+            }
+            had_some = true;
+        }
+        return had_some;
+    }
+
+    struct HashCollector {
+        std::unordered_set<uint32_t>& fnv1a;
+        std::unordered_set<uint64_t>& xxh64;
+
+        void hash(FNV1a const& value) noexcept {
+            if (value.str().empty() && value.hash() != 0) {
+                fnv1a.insert(value.hash());
+            }
+        }
+
+        void hash(XXH64 const& value) noexcept {
+            if (value.str().empty() && value.hash() != 0) {
+                xxh64.insert(value.hash());
+            }
+        }
+
+        void value(Value const& value, int max_depth) noexcept {
+            if (max_depth <= 0) {
+                return;
+            }
+            std::visit([this, max_depth](auto const& value) noexcept {
+                using value_t = std::remove_cvref_t<decltype(value)>;
+                if constexpr (value_t::category == Category::HASH) {
+                    hash(value.value);
+                } else if constexpr (value_t::category == Category::CLASS) {
+                    hash(value.name);
+                    for (auto const& item : value.items) {
+                        hash(item.key);
+                        this->value(item.value, max_depth - 1);
+                    }
+                } else if constexpr (value_t::category == Category::MAP) {
+                    for (auto const& item : value.items) {
+                        this->value(item.key, max_depth - 1);
+                        this->value(item.value, max_depth - 1);
+                    }
+                } else if constexpr (value_t::category == Category::LIST || value_t::category == Category::OPTION) {
+                    // Packed items are numbers and vectors, nothing to collect
+                    if (value.items.packed_type() != Type::NONE) {
+                        return;
+                    }
+                    for (auto const& item : value.items) {
+                        this->value(item.value, max_depth - 1);
+                    }
+                }
+            }, value);
+        }
+    };
+
+    // Same as HashCollector but reads hashes straight from encoded buffer
+    struct ViewHashCollector {
+        std::unordered_set<uint32_t>& fnv1a;
+        std::unordered_set<uint64_t>& xxh64;
+
+        void hash(uint32_t value) noexcept {
+            if (value != 0) {
+                fnv1a.insert(value);
+            }
+        }
+
+        void hash(uint64_t value) noexcept {
+            if (value != 0) {
+                xxh64.insert(value);
+            }
+        }
+
+        void fields(io::FieldCursor cursor, int max_depth) noexcept {
+            io::FieldView item = {};
+            while (cursor.next(item)) {
+                hash(item.key);
+                value(item.value, max_depth - 1);
+            }
+        }
+
+        void value(io::ValueView const& value, int max_depth) noexcept {
+            if (max_depth <= 0) {
+                return;
+            }
+            switch (ValueHelper::type_to_category(value.type)) {
+            case Category::HASH:
+                if (value.type == Type::FILE) {
+                    uint64_t result = {};
+                    if (value.read_hash(result)) {
+                        hash(result);
+                    }
+                } else {
+                    uint32_t result = {};
+                    if (value.read_hash(result)) {
+                        hash(result);
+                    }
+                }
+                break;
+            case Category::CLASS:
+                if (uint32_t name = {}; value.read_name(name)) {
+                    hash(name);
+                    fields(value.fields(), max_depth);
+                }
+                break;
+            case Category::MAP: {
+                auto cursor = value.pairs();
+                io::PairView item = {};
+                while (cursor.next(item)) {
+                    this->value(item.key, max_depth - 1);
+                    this->value(item.value, max_depth - 1);
+                }
+                break;
+            }
+            case Category::LIST:
+            case Category::OPTION: {
+                auto cursor = value.items();
+                // Numbers, vectors and strings have no hashes, skip walking them
+                switch (ValueHelper::type_to_category(cursor.valueType)) {
+                case Category::NUMBER:
+                case Category::VECTOR:
+                case Category::STRING:
+                    return;
+                default:
+                    break;
+                }
+                io::ValueView item = {};
+                while (cursor.next(item)) {
+                    this->value(item, max_depth - 1);
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    };
+
+    template<typename T>
+    static inline void write_raw(std::string& out, T value) noexcept {
+        out.append(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+}
 
 namespace ritobin {
+    using namespace unhash_impl;
+
+    template<typename T>
+    bool HashDB<T>::load(std::string const& filename) noexcept {
+        *this = {};
+        auto file = fopen(filename.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        auto const ok = file_.map(file);
+        fclose(file);
+        if (!ok) {
+            return false;
+        }
+        auto const data = file_.data();
+        auto const size = file_.size();
+        if (size < DB_HEADER_SIZE
+            || memcmp(data, DB_MAGIC, sizeof(DB_MAGIC)) != 0
+            || read_raw<uint32_t>(data + 4) != DB_VERSION
+            || read_raw<uint32_t>(data + 8) != sizeof(T)) {
+            *this = {};
+            return false;
+        }
+        auto const count = size_t{ read_raw<uint32_t>(data + 12) };
+        auto const chars_start = DB_HEADER_SIZE + count * sizeof(T) + (count + 1) * sizeof(uint32_t);
+        if (size < chars_start) {
+            *this = {};
+            return false;
+        }
+        hashes_ = data + DB_HEADER_SIZE;
+        offsets_ = hashes_ + count * sizeof(T);
+        chars_ = data + chars_start;
+        count_ = count;
+        chars_size_ = size - chars_start;
+        if (read_raw<uint32_t>(offsets_ + count * sizeof(uint32_t)) > chars_size_) {
+            *this = {};
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    std::string_view HashDB<T>::find(T hash) const noexcept {
+        size_t first = 0;
+        size_t last = count_;
+        while (first < last) {
+            auto const middle = first + (last - first) / 2;
+            if (read_raw<T>(hashes_ + middle * sizeof(T)) < hash) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+        if (first == count_ || read_raw<T>(hashes_ + first * sizeof(T)) != hash) {
+            return {};
+        }
+        auto const beg = read_raw<uint32_t>(offsets_ + first * sizeof(uint32_t));
+        auto const end = read_raw<uint32_t>(offsets_ + (first + 1) * sizeof(uint32_t));
+        if (beg > end || end > chars_size_) {
+            return {};
+        }
+        return { chars_ + beg, end - beg };
+    }
+
+    template<typename T>
+    bool HashDB<T>::save(std::string const& filename, std::unordered_map<T, std::string> const& hashes) noexcept {
+        auto sorted = std::vector<std::pair<T, std::string_view>>(hashes.begin(), hashes.end());
+        std::sort(sorted.begin(), sorted.end());
+        size_t chars_size = 0;
+        for (auto const& [hash, str]: sorted) {
+            chars_size += str.size();
+        }
+        if (sorted.size() > UINT32_MAX || chars_size > UINT32_MAX) {
+            return false;
+        }
+        auto out = std::string{};
+        out.reserve(DB_HEADER_SIZE + sorted.size() * (sizeof(T) + sizeof(uint32_t)) + sizeof(uint32_t) + chars_size);
+        out.append(DB_MAGIC, sizeof(DB_MAGIC));
+        write_raw(out, DB_VERSION);
+        write_raw(out, static_cast<uint32_t>(sizeof(T)));
+        write_raw(out, static_cast<uint32_t>(sorted.size()));
+        for (auto const& [hash, str]: sorted) {
+            write_raw(out, hash);
+        }
+        uint32_t offset = 0;
+        for (auto const& [hash, str]: sorted) {
+            write_raw(out, offset);
+            offset += static_cast<uint32_t>(str.size());
+        }
+        write_raw(out, offset);
+        for (auto const& [hash, str]: sorted) {
+            out.append(str);
+        }
+        std::ofstream file(filename, std::ios::binary);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        return static_cast<bool>(file);
+    }
+
+    template struct HashDB<uint32_t>;
+    template struct HashDB<uint64_t>;
+
     struct BinUnhasherVisit {
         static void value(BinUnhasher const&, None const&, int) noexcept {}
 
@@ -49,12 +396,18 @@ namespace ritobin {
         }
 
         static void value(BinUnhasher const& unhasher, List& value, int max_depth) noexcept {
+            if (value.items.packed_type() != Type::NONE) {
+                return;
+            }
             for (auto& item : value.items) {
                 unhasher.unhash_value(item.value, max_depth);
             }
         }
 
         static void value(BinUnhasher const& unhasher, List2& value, int max_depth) noexcept {
+            if (value.items.packed_type() != Type::NONE) {
+                return;
+            }
             for (auto& item : value.items) {
                 unhasher.unhash_value(item.value, max_depth);
             }
@@ -96,18 +449,69 @@ namespace ritobin {
         static void value(BinUnhasher const&, Flag const&, int) noexcept {}
     };
 
+    void UnhashStats::add(UnhashStats const& other) noexcept {
+        fnv1a_lookups += other.fnv1a_lookups;
+        fnv1a_map_hits += other.fnv1a_map_hits;
+        fnv1a_db_hits += other.fnv1a_db_hits;
+        xxh64_lookups += other.xxh64_lookups;
+        xxh64_map_hits += other.xxh64_map_hits;
+        xxh64_db_hits += other.xxh64_db_hits;
+    }
+
+    std::string_view BinUnhasher::find_name(uint32_t hash) const noexcept {
+        if (hash == 0) {
+            return {};
+        }
+        auto const stats = UnhashStats::Scope::current();
+        if (stats) {
+            stats->fnv1a_lookups++;
+        }
+        if (auto i = fnv1a.find(hash); i != fnv1a.end()) {
+            if (stats) {
+                stats->fnv1a_map_hits++;
+            }
+            return i->second;
+        }
+        auto const str = fnv1a_db.find(hash);
+        if (stats && !str.empty()) {
+            stats->fnv1a_db_hits++;
+        }
+        return str;
+    }
+
+    std::string_view BinUnhasher::find_name(uint64_t hash) const noexcept {
+        if (hash == 0) {
+            return {};
+        }
+        auto const stats = UnhashStats::Scope::current();
+        if (stats) {
+            stats->xxh64_lookups++;
+        }
+        if (auto i = xxh64.find(hash); i != xxh64.end()) {
+            if (stats) {
+                stats->xxh64_map_hits++;
+            }
+            return i->second;
+        }
+        auto const str = xxh64_db.find(hash);
+        if (stats && !str.empty()) {
+            stats->xxh64_db_hits++;
+        }
+        return str;
+    }
+
     void BinUnhasher::unhash_hash(FNV1a& value) const noexcept {
-        if (value.str().empty() && value.hash() != 0) {
-            if (auto i = fnv1a.find(value.hash()); i != fnv1a.end()) {
-                value = FNV1a(i->second);
+        if (value.str().empty()) {
+            if (auto const name = find_name(value.hash()); !name.empty()) {
+                value = FNV1a(name);
             }
         }
     }
 
     void BinUnhasher::unhash_hash(XXH64& value) const noexcept {
-        if (value.str().empty() && value.hash() != 0) {
-            if (auto i = xxh64.find(value.hash()); i != xxh64.end()) {
-                value = XXH64(i->second);
+        if (value.str().empty()) {
+            if (auto const name = find_name(value.hash()); !name.empty()) {
+                value = XXH64(name);
             }
         }
     }
@@ -127,72 +531,62 @@ namespace ritobin {
     }
 
     bool BinUnhasher::load_fnv1a_CDTB(std::istream& istream) noexcept {
-        if (!istream) {
-            return false;
-        }
-        auto line = std::string{};
-        while (std::getline(istream, line)) {
-            if (line.empty()) {
-                break;
-            }
-            auto const beg = line.data();
-            auto const space = line.find_first_of(' ');
-            auto const length = line.size();
-            if (space != length) {
-                auto hash = uint32_t{};
-                std::from_chars(beg, beg + space, hash, 16);
-                fnv1a[hash] = { beg + space + 1, length - space - 1 };
-            }
-        }
-        return true;
+        return load_CDTB(istream, fnv1a, only_wanted ? &fnv1a_wanted : nullptr);
     }
 
     bool BinUnhasher::load_fnv1a_CDTB(std::string const& filename) noexcept {
-        if (std::ifstream file(filename); load_fnv1a_CDTB(file)) {
-            return true;
-        }
-        bool had_some = false;
-        for (size_t i = 0;;i++) {
-            if (std::ifstream file(filename + "." + std::to_string(i)); !load_fnv1a_CDTB(file)) {
-                break;
-            }
-            had_some = true;
-        }
-        return had_some;
+        return load_CDTB(filename, fnv1a, only_wanted ? &fnv1a_wanted : nullptr);
     }
 
     bool BinUnhasher::load_xxh64_CDTB(std::istream& istream) noexcept {
-        if (!istream) {
-            return false;
-        }
-        auto line = std::string{};
-        while (std::getline(istream, line)) {
-            if (line.empty()) {
-                break;
-            }
-            auto const beg = line.data();
-            auto const space = line.find_first_of(' ');
-            auto const length = line.size();
-            if (space != length) {
-                auto hash = uint64_t{};
-                std::from_chars(beg, beg + space, hash, 16);
-                xxh64[hash] = { beg + space + 1, length - space - 1 };
-            }
-        }
-        return true;
+        return load_CDTB(istream, xxh64, only_wanted ? &xxh64_wanted : nullptr);
     }
 
     bool BinUnhasher::load_xxh64_CDTB(std::string const& filename) noexcept {
-        if (std::ifstream file(filename); load_xxh64_CDTB(file)) {
-            return true;
+        return load_CDTB(filename, xxh64, only_wanted ? &xxh64_wanted : nullptr);
+    }
+
+    void BinUnhasher::collect_bin(Bin const& bin, int max_depth) noexcept {
+        only_wanted = true;
+        auto collector = HashCollector { fnv1a_wanted, xxh64_wanted };
+        for (auto const& [key, value] : bin.sections) {
+            collector.value(value, max_depth);
         }
-        bool had_some = false;
-        for (size_t i = 0;;i++) {
-            if (std::ifstream file(filename + "." + std::to_string(i)); !load_xxh64_CDTB(file)) {
-                break;
+    }
+
+    void BinUnhasher::collect_view(io::BinView const& view, int max_depth) noexcept {
+        only_wanted = true;
+        auto collector = ViewHashCollector { fnv1a_wanted, xxh64_wanted };
+        auto entries = view.entries();
+        io::EntryView entry = {};
+        while (entries.next(entry)) {
+            collector.hash(entry.key);
+            collector.hash(entry.name);
+            collector.fields(entry.fields(), max_depth);
+        }
+        if (view.is_patch()) {
+            auto patches = view.patches();
+            io::PatchView patch = {};
+            while (patches.next(patch)) {
+                collector.hash(patch.key);
+                collector.value(patch.value, max_depth);
             }
-            had_some = true;
         }
-        return had_some;
+    }
+
+    bool BinUnhasher::load_fnv1a_DB(std::string const& filename) noexcept {
+        return fnv1a_db.load(filename);
+    }
+
+    bool BinUnhasher::load_xxh64_DB(std::string const& filename) noexcept {
+        return xxh64_db.load(filename);
+    }
+
+    bool BinUnhasher::save_fnv1a_DB(std::string const& filename) const noexcept {
+        return HashDB<uint32_t>::save(filename, fnv1a);
+    }
+
+    bool BinUnhasher::save_xxh64_DB(std::string const& filename) const noexcept {
+        return HashDB<uint64_t>::save(filename, xxh64);
     }
 }
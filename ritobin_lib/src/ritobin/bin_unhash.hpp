@@ -2,21 +2,106 @@
 #define BIN_UNHASH_HPP
 
 #include "bin_types.hpp"
+#include "bin_mmap.hpp"
 #include <istream>
+#include <unordered_set>
+#include <utility>
+
+namespace ritobin::io {
+    struct BinView;
+}
 
 namespace ritobin {
+    // Precompiled hash table, mapped from disk and queried in place.
+    //
+    // layout (little endian):
+    //  - header: magic "RHDB", u32 version, u32 size of hash, u32 count
+    //  - count hashes in ascending order
+    //  - count + 1 u32 offsets into string blob
+    //  - string blob
+    template<typename T>
+    struct HashDB {
+        bool load(std::string const& filename) noexcept;
+
+        std::string_view find(T hash) const noexcept;
+
+        inline size_t size() const noexcept {
+            return count_;
+        }
+
+        static bool save(std::string const& filename, std::unordered_map<T, std::string> const& hashes) noexcept;
+    private:
+        MappedFile file_ = {};
+        char const* hashes_ = {};
+        char const* offsets_ = {};
+        char const* chars_ = {};
+        size_t count_ = {};
+        size_t chars_size_ = {};
+    };
+
+    extern template struct HashDB<uint32_t>;
+    extern template struct HashDB<uint64_t>;
+
+    // Lookups of hashes without names done by BinUnhasher on threads where scope() is alive
+    struct UnhashStats {
+        size_t fnv1a_lookups = {};
+        size_t fnv1a_map_hits = {};
+        size_t fnv1a_db_hits = {};
+        size_t xxh64_lookups = {};
+        size_t xxh64_map_hits = {};
+        size_t xxh64_db_hits = {};
+
+        struct Scope {
+            explicit Scope(UnhashStats* stats) noexcept : previous_(std::exchange(current_, stats)) {}
+            Scope(Scope const&) = delete;
+            Scope& operator=(Scope const&) = delete;
+            ~Scope() noexcept { current_ = previous_; }
+
+            static UnhashStats* current() noexcept {
+                return current_;
+            }
+        private:
+            static inline thread_local UnhashStats* current_ = nullptr;
+            UnhashStats* previous_;
+        };
+
+        Scope scope() noexcept { return Scope { this }; }
+
+        void add(UnhashStats const& other) noexcept;
+    };
+
     struct BinUnhasher {
         std::unordered_map<uint32_t, std::string> fnv1a;
         std::unordered_map<uint64_t, std::string> xxh64;
+        // Looked up when hash is not found in maps above
+        HashDB<uint32_t> fnv1a_db;
+        HashDB<uint64_t> xxh64_db;
+        // Hashes that still need a name, see collect_bin
+        std::unordered_set<uint32_t> fnv1a_wanted;
+        std::unordered_set<uint64_t> xxh64_wanted;
+        // When set load_*_CDTB only keeps lines for hashes in *_wanted
+        bool only_wanted = false;
 
         void unhash_bin(Bin& bin, int max_depth = 100) const noexcept;
         void unhash_value(Value& bin, int max_depth) const noexcept;
         void unhash_hash(FNV1a& bin) const noexcept;
         void unhash_hash(XXH64& bin) const noexcept;
+        // Name of hash from maps or tables, empty when there is none
+        std::string_view find_name(uint32_t hash) const noexcept;
+        std::string_view find_name(uint64_t hash) const noexcept;
+        // Adds every hash without name to *_wanted and sets only_wanted
+        void collect_bin(Bin const& bin, int max_depth = 100) noexcept;
+        // Same as collect_bin without decoding, every hash in view is wanted
+        void collect_view(io::BinView const& view, int max_depth = 100) noexcept;
         bool load_fnv1a_CDTB(std::istream& istream) noexcept;
         bool load_fnv1a_CDTB(std::string const& filename) noexcept;
         bool load_xxh64_CDTB(std::istream& istream) noexcept;
         bool load_xxh64_CDTB(std::string const& filename) noexcept;
+        bool load_fnv1a_DB(std::string const& filename) noexcept;
+        bool load_xxh64_DB(std::string const& filename) noexcept;
+        // Compiles hashes loaded into maps into table for load_*_DB
+        bool save_fnv1a_DB(std::string const& filename) const noexcept;
+        bool save_xxh64_DB(std::string const& filename) const noexcept;
     };
 }
 
@@ -0,0 +1,494 @@
+#include "bin_view.hpp"
+#include "bin_types_helper.hpp"
+
+namespace ritobin::io::view_impl {
+    struct ViewReader {
+        char const* cur_;
+        char const* const cap_;
+        BinCompat const* const compat_;
+
+        template<typename T>
+        inline bool read(T& value) noexcept {
+            static_assert(std::is_arithmetic_v<T>);
+            if (cur_ + sizeof(T) > cap_) {
+                return false;
+            }
+            memcpy(&value, cur_, sizeof(T));
+            cur_ += sizeof(T);
+            return true;
+        }
+
+        bool read(Type& value) noexcept {
+            uint8_t raw = {};
+            if (!read(raw)) {
+                return false;
+            }
+            return compat_->raw_to_type(raw, value);
+        }
+
+        bool read(std::string_view& value) noexcept {
+            uint16_t size = {};
+            if (!read(size)) {
+                return false;
+            }
+            if (cur_ + size > cap_) {
+                return false;
+            }
+            value = { cur_, size };
+            cur_ += size;
+            return true;
+        }
+
+        bool skip(size_t size) noexcept {
+            if (cur_ + size > cap_) {
+                return false;
+            }
+            cur_ += size;
+            return true;
+        }
+
+        bool skip_sized() noexcept {
+            uint32_t size = {};
+            return read(size) && skip(size);
+        }
+
+        bool skip_value(Type type) noexcept {
+            switch (type) {
+            case Type::BOOL:
+            case Type::I8:
+            case Type::U8:
+            case Type::FLAG:
+                return skip(1);
+            case Type::I16:
+            case Type::U16:
+                return skip(2);
+            case Type::I32:
+            case Type::U32:
+            case Type::F32:
+            case Type::RGBA:
+            case Type::HASH:
+            case Type::LINK:
+                return skip(4);
+            case Type::I64:
+            case Type::U64:
+            case Type::VEC2:
+            case Type::FILE:
+                return skip(8);
+            case Type::VEC3:
+                return skip(12);
+            case Type::VEC4:
+                return skip(16);
+            case Type::MTX44:
+                return skip(64);
+            case Type::STRING: {
+                std::string_view str = {};
+                return read(str);
+            }
+            case Type::EMBED:
+                return skip(4) && skip_sized();
+            case Type::POINTER: {
+                uint32_t name = {};
+                if (!read(name)) {
+                    return false;
+                }
+                return name == 0 || skip_sized();
+            }
+            case Type::LIST:
+            case Type::LIST2: {
+                Type valueType = {};
+                return read(valueType) && skip_sized();
+            }
+            case Type::MAP: {
+                Type keyType = {};
+                Type valueType = {};
+                return read(keyType) && read(valueType) && skip_sized();
+            }
+            case Type::OPTION: {
+                Type valueType = {};
+                uint8_t count = {};
+                if (!read(valueType) || ValueHelper::is_container(valueType) || !read(count)) {
+                    return false;
+                }
+                return count == 0 || skip_value(valueType);
+            }
+            default:
+                return false;
+            }
+        }
+
+        bool read_view(ValueView& view, Type type) noexcept {
+            auto const beg = cur_;
+            if (!skip_value(type)) {
+                return false;
+            }
+            view = { type, { beg, cur_ }, compat_ };
+            return true;
+        }
+
+        // Reads size + count header of sized container, limits cap to size
+        template<typename T>
+        bool read_body(T& cursor) noexcept {
+            uint32_t size = {};
+            if (!read(size) || cur_ + size > cap_) {
+                return false;
+            }
+            auto const end = cur_ + size;
+            if constexpr (std::is_same_v<T, FieldCursor>) {
+                uint16_t count = {};
+                if (!read(count)) {
+                    return false;
+                }
+                cursor.left_ = count;
+            } else {
+                uint32_t count = {};
+                if (!read(count)) {
+                    return false;
+                }
+                cursor.left_ = count;
+            }
+            if (cur_ > end) {
+                return false;
+            }
+            cursor.cur_ = cur_;
+            cursor.cap_ = end;
+            cursor.compat_ = compat_;
+            return true;
+        }
+    };
+
+    static bool find_field(FieldCursor cursor, uint32_t key, ValueView& value) noexcept {
+        FieldView field = {};
+        while (cursor.next(field)) {
+            if (field.key == key) {
+                value = field.value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool read_fields(FieldCursor cursor, FieldList& items) noexcept {
+        items.reserve(cursor.size());
+        FieldView field = {};
+        while (cursor.next(field)) {
+            auto& [key, item] = items.emplace_back(FNV1a{ field.key }, Value{});
+            if (!field.value.read(item)) {
+                return false;
+            }
+        }
+        return cursor.ok();
+    }
+}
+
+namespace ritobin::io {
+    using namespace view_impl;
+
+    bool CursorBase::fail() noexcept {
+        left_ = 0;
+        ok_ = false;
+        return false;
+    }
+
+    bool CursorBase::done() noexcept {
+        if (cur_ != cap_) {
+            return fail();
+        }
+        return false;
+    }
+
+    bool ElementCursor::next(ValueView& item) noexcept {
+        if (left_ == 0) {
+            return done();
+        }
+        ViewReader reader = { cur_, cap_, compat_ };
+        if (!reader.read_view(item, valueType)) {
+            return fail();
+        }
+        cur_ = reader.cur_;
+        left_--;
+        return true;
+    }
+
+    bool FieldCursor::next(FieldView& item) noexcept {
+        if (left_ == 0) {
+            return done();
+        }
+        ViewReader reader = { cur_, cap_, compat_ };
+        Type type = {};
+        if (!reader.read(item.key) || !reader.read(type) || !reader.read_view(item.value, type)) {
+            return fail();
+        }
+        cur_ = reader.cur_;
+        left_--;
+        return true;
+    }
+
+    bool PairCursor::next(PairView& item) noexcept {
+        if (left_ == 0) {
+            return done();
+        }
+        ViewReader reader = { cur_, cap_, compat_ };
+        if (!reader.read_view(item.key, keyType) || !reader.read_view(item.value, valueType)) {
+            return fail();
+        }
+        cur_ = reader.cur_;
+        left_--;
+        return true;
+    }
+
+    bool EntryCursor::next(EntryView& item) noexcept {
+        if (left_ == 0) {
+            return done();
+        }
+        ViewReader reader = { cur_, cap_, compat_ };
+        uint32_t length = {};
+        if (!reader.read(length)) {
+            return fail();
+        }
+        auto const beg = reader.cur_;
+        if (!reader.skip(length) || !ViewReader { beg, reader.cur_, compat_ }.read(item.key)) {
+            return fail();
+        }
+        memcpy(&item.name, names_, sizeof(uint32_t));
+        item.data = { beg, reader.cur_ };
+        item.compat = compat_;
+        names_ += sizeof(uint32_t);
+        cur_ = reader.cur_;
+        left_--;
+        return true;
+    }
+
+    bool PatchCursor::next(PatchView& item) noexcept {
+        if (left_ == 0) {
+            return done();
+        }
+        ViewReader reader = { cur_, cap_, compat_ };
+        uint32_t length = {};
+        if (!reader.read(item.key) || !reader.read(length)) {
+            return fail();
+        }
+        auto const end = reader.cur_ + length;
+        Type type = {};
+        if (end > cap_
+            || !reader.read(type)
+            || !reader.read(item.path)
+            || !reader.read_view(item.value, type)
+            || reader.cur_ != end) {
+            return fail();
+        }
+        cur_ = reader.cur_;
+        left_--;
+        return true;
+    }
+
+    bool ValueView::read_name(uint32_t& value) const noexcept {
+        if (type != Type::EMBED && type != Type::POINTER) {
+            return false;
+        }
+        return ViewReader { data.data(), data.data() + data.size(), compat }.read(value);
+    }
+
+    bool ValueView::read_string(std::string_view& value) const noexcept {
+        if (type != Type::STRING) {
+            return false;
+        }
+        return ViewReader { data.data(), data.data() + data.size(), compat }.read(value);
+    }
+
+    bool ValueView::read_hash(uint32_t& value) const noexcept {
+        if (type != Type::HASH && type != Type::LINK) {
+            return false;
+        }
+        return ViewReader { data.data(), data.data() + data.size(), compat }.read(value);
+    }
+
+    bool ValueView::read_hash(uint64_t& value) const noexcept {
+        if (type != Type::FILE) {
+            return false;
+        }
+        return ViewReader { data.data(), data.data() + data.size(), compat }.read(value);
+    }
+
+    ElementCursor ValueView::items() const noexcept {
+        ElementCursor cursor = {};
+        ViewReader reader = { data.data(), data.data() + data.size(), compat };
+        if (type == Type::LIST || type == Type::LIST2) {
+            if (!reader.read(cursor.valueType) || !reader.read_body(cursor)) {
+                cursor.ok_ = false;
+                cursor.left_ = 0;
+            }
+        } else if (type == Type::OPTION) {
+            uint8_t count = {};
+            if (reader.read(cursor.valueType) && reader.read(count)) {
+                // Only one item is ever stored no matter what count says
+                cursor = { { reader.cur_, reader.cap_, compat, count != 0 ? 1u : 0u }, cursor.valueType };
+            } else {
+                cursor.ok_ = false;
+            }
+        }
+        return cursor;
+    }
+
+    FieldCursor ValueView::fields() const noexcept {
+        FieldCursor cursor = {};
+        ViewReader reader = { data.data(), data.data() + data.size(), compat };
+        uint32_t name = {};
+        if (type != Type::EMBED && type != Type::POINTER) {
+            return cursor;
+        }
+        if (!reader.read(name)) {
+            cursor.ok_ = false;
+            return cursor;
+        }
+        if (type == Type::POINTER && name == 0) {
+            return cursor;
+        }
+        if (!reader.read_body(cursor)) {
+            cursor.ok_ = false;
+            cursor.left_ = 0;
+        }
+        return cursor;
+    }
+
+    PairCursor ValueView::pairs() const noexcept {
+        PairCursor cursor = {};
+        ViewReader reader = { data.data(), data.data() + data.size(), compat };
+        if (type != Type::MAP) {
+            return cursor;
+        }
+        if (!reader.read(cursor.keyType) || !reader.read(cursor.valueType) || !reader.read_body(cursor)) {
+            cursor.ok_ = false;
+            cursor.left_ = 0;
+        }
+        return cursor;
+    }
+
+    bool ValueView::find_field(uint32_t key, ValueView& value) const noexcept {
+        return view_impl::find_field(fields(), key, value);
+    }
+
+    bool ValueView::read(Value& value) const noexcept {
+        return read_binary(value, type, data, compat).empty();
+    }
+
+    FieldCursor EntryView::fields() const noexcept {
+        FieldCursor cursor = {};
+        ViewReader reader = { data.data(), data.data() + data.size(), compat };
+        uint32_t entryKey = {};
+        uint16_t count = {};
+        if (!reader.read(entryKey) || !reader.read(count)) {
+            cursor.ok_ = false;
+            return cursor;
+        }
+        cursor = { { reader.cur_, reader.cap_, compat, count } };
+        return cursor;
+    }
+
+    bool EntryView::find_field(uint32_t key, ValueView& value) const noexcept {
+        return view_impl::find_field(fields(), key, value);
+    }
+
+    bool EntryView::read(Embed& value) const noexcept {
+        value.name = FNV1a{ name };
+        value.items.clear();
+        return read_fields(fields(), value.items);
+    }
+
+    std::string BinView::open(std::span<char const> data, BinCompat const* compat) noexcept {
+        *this = {};
+        data_ = data;
+        compat_ = compat;
+        ViewReader reader = { data.data(), data.data() + data.size(), compat };
+        auto fail = [&](std::string msg, char const* pos) {
+            return msg + " @ " + std::to_string(pos - data.data()) + "\n";
+        };
+        std::array<char, 4> magic = {};
+        if (!reader.read(magic[0]) || !reader.read(magic[1]) || !reader.read(magic[2]) || !reader.read(magic[3])) {
+            return fail("Failed to read magic", data.data());
+        }
+        if (magic == std::array{ 'P', 'T', 'C', 'H' }) {
+            uint64_t unk = {};
+            if (!reader.read(unk)
+                || !reader.read(magic[0]) || !reader.read(magic[1]) || !reader.read(magic[2]) || !reader.read(magic[3])) {
+                return fail("Failed to read patch header", data.data());
+            }
+            is_patch_ = true;
+        }
+        if (magic != std::array{ 'P', 'R', 'O', 'P' }) {
+            return fail("Bad magic", reader.cur_ - 4);
+        }
+        if (!reader.read(version_)) {
+            return fail("Failed to read version", reader.cur_);
+        }
+        if (version_ >= 2) {
+            if (!reader.read(linked_count_)) {
+                return fail("Failed to read linked count", reader.cur_);
+            }
+            auto const beg = reader.cur_;
+            for (uint32_t i = 0; i != linked_count_; i++) {
+                auto const pos = reader.cur_;
+                std::string_view linked = {};
+                if (!reader.read(linked)) {
+                    return fail("Failed to read linked " + std::to_string(i), pos);
+                }
+            }
+            linked_ = { beg, reader.cur_ };
+        }
+        if (!reader.read(entry_count_)) {
+            return fail("Failed to read entry count", reader.cur_);
+        }
+        entry_names_ = reader.cur_;
+        if (!reader.skip(sizeof(uint32_t) * size_t{ entry_count_ })) {
+            return fail("Failed to read entry names", reader.cur_);
+        }
+        {
+            auto const beg = reader.cur_;
+            for (uint32_t i = 0; i != entry_count_; i++) {
+                auto const pos = reader.cur_;
+                if (!reader.skip_sized()) {
+                    return fail("Failed to read entry " + std::to_string(i), pos);
+                }
+            }
+            entries_ = { beg, reader.cur_ };
+        }
+        if (is_patch_) {
+            if (!reader.read(patch_count_)) {
+                return fail("Failed to read patch count", reader.cur_);
+            }
+            auto const beg = reader.cur_;
+            for (uint32_t i = 0; i != patch_count_; i++) {
+                auto const pos = reader.cur_;
+                if (!reader.skip(4) || !reader.skip_sized()) {
+                    return fail("Failed to read patch " + std::to_string(i), pos);
+                }
+            }
+            patches_ = { beg, reader.cur_ };
+        }
+        if (reader.cur_ != reader.cap_) {
+            return fail("Trailing data", reader.cur_);
+        }
+        return {};
+    }
+
+    ElementCursor BinView::linked() const noexcept {
+        return { { linked_.data(), linked_.data() + linked_.size(), compat_, linked_count_ }, Type::STRING };
+    }
+
+    EntryCursor BinView::entries() const noexcept {
+        return { { entries_.data(), entries_.data() + entries_.size(), compat_, entry_count_ }, entry_names_ };
+    }
+
+    PatchCursor BinView::patches() const noexcept {
+        return { { patches_.data(), patches_.data() + patches_.size(), compat_, patch_count_ } };
+    }
+
+    bool BinView::find_entry(uint32_t key, EntryView& entry) const noexcept {
+        auto cursor = entries();
+        while (cursor.next(entry)) {
+            if (entry.key == key) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
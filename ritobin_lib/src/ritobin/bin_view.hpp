@@ -0,0 +1,211 @@
+#ifndef BIN_VIEW_HPP
+#define BIN_VIEW_HPP
+
+#include "bin_io.hpp"
+#include <cstdio>
+
+namespace ritobin {
+    struct BinUnhasher;
+}
+
+// Read-only views over .bin buffers.
+// Nothing is decoded up front, views keep pointers into original buffer and
+// use size prefixes to skip over subtrees that are never looked at.
+// Buffer must outlive every view and cursor created from it.
+namespace ritobin::io {
+    struct ValueView;
+    struct FieldView;
+    struct PairView;
+    struct EntryView;
+    struct PatchView;
+
+    struct CursorBase {
+        char const* cur_ = {};
+        char const* cap_ = {};
+        BinCompat const* compat_ = {};
+        uint32_t left_ = {};
+        bool ok_ = true;
+
+        // Number of items not yet visited
+        inline size_t size() const noexcept {
+            return left_;
+        }
+
+        // False if cursor stopped because of malformed data
+        inline bool ok() const noexcept {
+            return ok_;
+        }
+    protected:
+        bool fail() noexcept;
+        // Ends iteration, fails when items did not use up all bytes of container
+        bool done() noexcept;
+    };
+
+    // Items of list, list2 or option
+    struct ElementCursor : CursorBase {
+        using item_type = ValueView;
+
+        Type valueType = {};
+        bool next(ValueView& item) noexcept;
+    };
+
+    // Fields of embed, pointer or entry
+    struct FieldCursor : CursorBase {
+        using item_type = FieldView;
+
+        bool next(FieldView& item) noexcept;
+    };
+
+    // Items of map
+    struct PairCursor : CursorBase {
+        using item_type = PairView;
+
+        Type keyType = {};
+        Type valueType = {};
+        bool next(PairView& item) noexcept;
+    };
+
+    struct EntryCursor : CursorBase {
+        using item_type = EntryView;
+
+        char const* names_ = {};
+        bool next(EntryView& item) noexcept;
+    };
+
+    struct PatchCursor : CursorBase {
+        using item_type = PatchView;
+
+        bool next(PatchView& item) noexcept;
+    };
+
+    struct ValueView {
+        Type type = Type::NONE;
+        // Exact encoded bytes of this value
+        std::span<char const> data = {};
+        BinCompat const* compat = {};
+
+        // Class name of embed or pointer, 0 for null pointer
+        bool read_name(uint32_t& value) const noexcept;
+        bool read_string(std::string_view& value) const noexcept;
+        // Hash or link
+        bool read_hash(uint32_t& value) const noexcept;
+        // File
+        bool read_hash(uint64_t& value) const noexcept;
+
+        ElementCursor items() const noexcept;
+        FieldCursor fields() const noexcept;
+        PairCursor pairs() const noexcept;
+        bool find_field(uint32_t key, ValueView& value) const noexcept;
+
+        // Decodes whole value
+        bool read(Value& value) const noexcept;
+
+        template<typename T>
+        bool read(T& value) const noexcept {
+            if (T::type != type) {
+                return false;
+            }
+            if constexpr (T::category == Category::NUMBER || T::category == Category::VECTOR) {
+                if (data.size() != sizeof(value.value)) {
+                    return false;
+                }
+                memcpy(&value.value, data.data(), sizeof(value.value));
+                return true;
+            } else if constexpr (T::category == Category::STRING) {
+                std::string_view str = {};
+                if (!read_string(str)) {
+                    return false;
+                }
+                value.value = std::string(str);
+                return true;
+            } else if constexpr (T::category == Category::HASH) {
+                typename decltype(value.value)::storage_t hash = {};
+                if (!read_hash(hash)) {
+                    return false;
+                }
+                value.value = hash;
+                return true;
+            } else {
+                Value result = {};
+                if (!read(result)) {
+                    return false;
+                }
+                value = std::move(std::get<T>(result));
+                return true;
+            }
+        }
+    };
+
+    struct FieldView {
+        uint32_t key = {};
+        ValueView value = {};
+    };
+
+    struct PairView {
+        ValueView key = {};
+        ValueView value = {};
+    };
+
+    struct EntryView {
+        uint32_t key = {};
+        uint32_t name = {};
+        // Encoded bytes following entryLength
+        std::span<char const> data = {};
+        BinCompat const* compat = {};
+
+        FieldCursor fields() const noexcept;
+        bool find_field(uint32_t key, ValueView& value) const noexcept;
+        // Decodes whole entry
+        bool read(Embed& value) const noexcept;
+    };
+
+    struct PatchView {
+        uint32_t key = {};
+        std::string_view path = {};
+        ValueView value = {};
+    };
+
+    struct BinView {
+        // Validates framing of sections, returns error with offset of failing item on failure
+        std::string open(std::span<char const> data, BinCompat const* compat) noexcept;
+
+        // Whole buffer view was opened over
+        inline std::span<char const> data() const noexcept {
+            return data_;
+        }
+
+        inline bool is_patch() const noexcept {
+            return is_patch_;
+        }
+
+        inline uint32_t version() const noexcept {
+            return version_;
+        }
+
+        ElementCursor linked() const noexcept;
+        EntryCursor entries() const noexcept;
+        PatchCursor patches() const noexcept;
+        bool find_entry(uint32_t key, EntryView& entry) const noexcept;
+    private:
+        std::span<char const> data_ = {};
+        BinCompat const* compat_ = {};
+        bool is_patch_ = {};
+        uint32_t version_ = {};
+        std::span<char const> linked_ = {};
+        uint32_t linked_count_ = {};
+        char const* entry_names_ = {};
+        std::span<char const> entries_ = {};
+        uint32_t entry_count_ = {};
+        std::span<char const> patches_ = {};
+        uint32_t patch_count_ = {};
+    };
+
+    // Writes same text as write_text of decoded bin straight from view, without building Bin.
+    // Output goes to file in fixed size chunks so memory use does not grow with file size,
+    // on malformed data part of output may already be written and error traces path to failing value.
+    // Hashes are named from unhasher when given.
+    extern std::string write_text(BinView const& view, FILE* out, BinUnhasher const* unhasher = nullptr,
+                                  size_t indent_size = 2) noexcept;
+}
+
+#endif // BIN_VIEW_HPP